@@ -3,19 +3,102 @@
     Вариант 5, задание 5.3.3
 */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <locale.h>
 #include <stdbool.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <malloc.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(MATRIX_THREADS) && !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    !defined(MATRIX_NO_SIMD)
+#define MATRIX_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+#define MATRIX_ALIGNMENT 64
+
+#define MATRIX_FILE_SIGNATURE "MTX1"
+
+#define READER_BUFFER_SIZE (1 << 16)
+
+/*
+ * Типы элементов матрицы: тип C, суффикс имен порожденных для него
+ * функций и значение MatrixElementType.
+ */
+#define MATRIX_ELEMENT_TYPES(X) \
+	X(int8_t, Int8, MATRIX_ELEMENT_INT8) \
+	X(int16_t, Int16, MATRIX_ELEMENT_INT16) \
+	X(int, Int32, MATRIX_ELEMENT_INT32) \
+	X(float, Float, MATRIX_ELEMENT_FLOAT) \
+	X(double, Double, MATRIX_ELEMENT_DOUBLE)
 
+typedef enum
+{
+	MATRIX_ELEMENT_INT32 = 1,
+	MATRIX_ELEMENT_INT8 = 2,
+	MATRIX_ELEMENT_INT16 = 3,
+	MATRIX_ELEMENT_FLOAT = 4,
+	MATRIX_ELEMENT_DOUBLE = 5
+} MatrixElementType;
+
+/*
+ * Элементы матрицы типа elementType хранятся в одном выровненном по
+ * строке кэша блоке: строка i начинается с элемента i * stride, stride
+ * кратен MATRIX_ALIGNMENT / размер элемента, поэтому каждая строка тоже
+ * выровнена.
+ */
 typedef struct
 {
-	int** data;
+	void* data;
+	MatrixElementType elementType;
 	int rowCount;
 	int columnCount;
+	size_t stride;
 } Matrix;
 
+/*
+ * Заголовок двоичного файла матрицы (64 байта, порядок байтов машины).
+ * Элементы записаны по строкам с шагом stride начиная с dataOffset, как в
+ * памяти, поэтому отображенный в память файл используется как Matrix без
+ * копирования.
+ */
+typedef struct
+{
+	char signature[4];
+	uint32_t elementType;
+	uint64_t rowCount;
+	uint64_t columnCount;
+	uint64_t stride;
+	uint64_t dataOffset;
+	char reserved[24];
+} MatrixFileHeader;
+
+typedef struct
+{
+	Matrix matrix;
+	void* mapping;
+	size_t size;
+} MappedMatrix;
+
 typedef struct
 {
 	int row;
@@ -25,9 +108,157 @@ typedef struct
 typedef struct
 {
 	MatrixIndex* data;
-	int size;
+	size_t size;
+	size_t capacity;
 } MatrixIndexArray;
 
+typedef struct
+{
+	int* rowMin;
+	int* rowMax;
+	int* columnMin;
+	int* columnMax;
+} MatrixExtrema;
+
+/*
+ * Обрабатывает одну строку: находит ее минимум и максимум и обновляет
+ * текущие минимумы и максимумы столбцов. Все указатели указывают на
+ * элементы одного типа.
+ */
+typedef void (*ExtremaKernel)(const void* row, int count, void* rowMin,
+                              void* rowMax, void* columnMin, void* columnMax);
+
+/*
+ * Объединяет частичные экстремумы столбцов одной полосы с общими.
+ */
+typedef void (*ExtremaMerge)(void* columnMin, void* columnMax,
+                             const void* partMin, const void* partMax,
+                             int count);
+
+typedef void (*ParallelTask)(void* context, int index);
+
+/*
+ * Функции поиска для одного типа элементов. Экстремумы хранятся в
+ * массивах того же типа, что и элементы.
+ */
+typedef struct
+{
+	size_t size;
+	ExtremaKernel kernel;
+	ExtremaMerge mergeExtrema;
+	ParallelTask findBandSpecialElements;
+} MatrixElementOps;
+
+#ifdef MATRIX_THREADS
+typedef struct
+{
+	ParallelTask task;
+	void* context;
+	int index;
+} ParallelJob;
+#endif
+
+/*
+ * Поиск по полосам строк: полоса band содержит строки
+ * [rowCount * band / bandCount, rowCount * (band + 1) / bandCount).
+ * Для каждой полосы хранятся частичные экстремумы столбцов и свой список
+ * найденных элементов. Экстремумы имеют тип элементов матрицы.
+ */
+typedef struct
+{
+	Matrix matrix;
+	MatrixElementOps ops;
+	void* rowMin;
+	void* rowMax;
+	void* columnMin;
+	void* columnMax;
+	int bandCount;
+	void* bandColumnMin;
+	void* bandColumnMax;
+	size_t limit;
+	bool countOnly;
+	MatrixIndexArray* bandResults;
+	size_t* bandCounts;
+} SaddleSearch;
+
+/*
+ * Узел дерева отрезков над строкой или столбцом матрицы: узел 1 - корень,
+ * дети узла k - узлы 2k и 2k + 1, элементу index соответствует лист
+ * leafCount + index. Листья после последнего элемента заполнены
+ * значениями, не влияющими на экстремумы.
+ */
+typedef struct
+{
+	int min;
+	int max;
+} ExtremaNode;
+
+/*
+ * Матрица с изменяемыми элементами. Для каждой строки и каждого столбца
+ * хранится дерево отрезков минимумов и максимумов, значения элементов -
+ * в листьях этих деревьев. special - битовая маска текущих особых
+ * элементов по строкам. После изменения элемента в added и removed лежат
+ * элементы, ставшие и переставшие быть особыми.
+ */
+typedef struct
+{
+	int rowCount;
+	int columnCount;
+	size_t rowLeafCount;
+	size_t columnLeafCount;
+	ExtremaNode* rowTrees;
+	ExtremaNode* columnTrees;
+	uint64_t* special;
+	size_t specialCount;
+	MatrixIndexArray added;
+	MatrixIndexArray removed;
+} DynamicMatrix;
+
+/*
+ * Чтение целых чисел из текста большими блоками вместо scanf. bufferOffset
+ * - смещение начала буфера в файле.
+ */
+typedef struct
+{
+	FILE* stream;
+	char* buffer;
+	size_t size;
+	size_t position;
+	uint64_t bufferOffset;
+	bool failed;
+} IntegerReader;
+
+/*
+ * Загрузка текстовой матрицы по частям: байты с элементами
+ * [dataBegin, fileSize) делятся на chunkCount частей, число относится к
+ * той части, в которой оно начинается. Сначала в каждой части считается
+ * количество чисел, затем по этим количествам каждая часть знает номер
+ * своего первого элемента и разбирает числа прямо в матрицу.
+ */
+typedef struct
+{
+	const char* fileName;
+	Matrix matrix;
+	uint64_t dataBegin;
+	uint64_t fileSize;
+	int chunkCount;
+	size_t* firstIndices;
+	bool* failures;
+} TextMatrixLoad;
+
+typedef struct
+{
+	int threadCount;
+	const char* textFileName;
+	const char* streamFileName;
+	const char* binaryFileName;
+	const char* convertFileNames[2];
+	const char* updatesFileName;
+	MatrixElementType elementType;
+	bool countOnly;
+	size_t limit;
+} Options;
+
 void terminate(const char* message)
 {
 	puts(message);
@@ -44,160 +275,1911 @@ int max(int a, int b)
 	return ((a > b) ? a : b);
 }
 
-void createMatrix(Matrix* a, int rows, int columns)
+void* allocateAligned(size_t size)
+{
+	size = (size + MATRIX_ALIGNMENT - 1) / MATRIX_ALIGNMENT * MATRIX_ALIGNMENT;
+#ifdef _WIN32
+	return _aligned_malloc(size, MATRIX_ALIGNMENT);
+#else
+	return aligned_alloc(MATRIX_ALIGNMENT, size);
+#endif
+}
+
+void freeAligned(void* p)
+{
+#ifdef _WIN32
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
+
+#define GET_ELEMENT_SIZE(T, Suffix, Type) \
+	case Type: \
+		return sizeof(T);
+
+/*
+ * Возвращает 0 для неизвестного типа.
+ */
+size_t getMatrixElementSize(MatrixElementType type)
+{
+	switch (type)
+	{
+		MATRIX_ELEMENT_TYPES(GET_ELEMENT_SIZE)
+		default:
+			return 0;
+	}
+}
+
+size_t getMatrixStride(int columns, size_t elementSize)
+{
+	size_t rowAlignment = MATRIX_ALIGNMENT / elementSize;
+	return ((size_t)columns + rowAlignment - 1) / rowAlignment * rowAlignment;
+}
+
+void createMatrix(Matrix* a, MatrixElementType type, int rows, int columns)
 {
+	size_t elementSize = getMatrixElementSize(type);
+	a->elementType = type;
 	a->rowCount = rows;
 	a->columnCount = columns;
-	a->data = (int**)malloc(rows * sizeof(int*));
-	for (int i = 0; i < rows; i++)
+	a->stride = getMatrixStride(columns, elementSize);
+	a->data = allocateAligned((size_t)rows * a->stride * elementSize);
+	if (a->data == NULL)
 	{
-		a->data[i] = (int*)malloc(columns * sizeof(int));
+		terminate("Недостаточно памяти для матрицы такого размера!");
 	}
 }
 
 void deleteMatrix(Matrix* a)
 {
-	for (int i = 0; i < a->rowCount; i++)
-	{
-		free(a->data[i]);
-		a->data[i] = NULL;
-	}
-	
-	free(a->data);
+	freeAligned(a->data);
 	a->data = NULL;
 	
 	a->rowCount = 0;
 	a->columnCount = 0;
+	a->stride = 0;
+}
+
+void* getMatrixRowData(Matrix a, int row)
+{
+	return (char*)a.data +
+	       (size_t)row * a.stride * getMatrixElementSize(a.elementType);
+}
+
+/*
+ * Строка матрицы с элементами int (MATRIX_ELEMENT_INT32).
+ */
+int* getMatrixRow(Matrix a, int row)
+{
+	return (int*)a.data + (size_t)row * a.stride;
+}
+
+/*
+ * Функции для каждого типа элементов порождаются макросами, поэтому тип
+ * известен при компиляции и внутри циклов не выбирается. Векторные ядра
+ * используют команды сравнения своего типа: в 256-битном регистре AVX2
+ * обрабатывается 32 элемента int8, 16 int16, 8 int или float и 4 double.
+ * Значения NaN не поддерживаются.
+ */
+#define DEFINE_EXTREMA_FUNCTIONS(T, Suffix, Type) \
+void updateExtremaRange##Suffix(const T* row, int begin, int count, \
+                                T* minElement, T* maxElement, \
+                                T* columnMin, T* columnMax) \
+{ \
+	for (int j = begin; j < count; j++) \
+	{ \
+		*minElement = (row[j] < *minElement) ? row[j] : *minElement; \
+		*maxElement = (row[j] > *maxElement) ? row[j] : *maxElement; \
+		columnMin[j] = (row[j] < columnMin[j]) ? row[j] : columnMin[j]; \
+		columnMax[j] = (row[j] > columnMax[j]) ? row[j] : columnMax[j]; \
+	} \
+} \
+ \
+void updateExtremaScalar##Suffix(const void* rowData, int count, \
+                                 void* rowMin, void* rowMax, \
+                                 void* columnMin, void* columnMax) \
+{ \
+	const T* row = (const T*)rowData; \
+	T minElement = row[0]; \
+	T maxElement = row[0]; \
+	updateExtremaRange##Suffix(row, 0, count, &minElement, &maxElement, \
+	                           (T*)columnMin, (T*)columnMax); \
+	*(T*)rowMin = minElement; \
+	*(T*)rowMax = maxElement; \
+} \
+ \
+void mergeExtrema##Suffix(void* columnMinData, void* columnMaxData, \
+                          const void* partMinData, const void* partMaxData, \
+                          int count) \
+{ \
+	T* columnMin = (T*)columnMinData; \
+	T* columnMax = (T*)columnMaxData; \
+	const T* partMin = (const T*)partMinData; \
+	const T* partMax = (const T*)partMaxData; \
+	for (int j = 0; j < count; j++) \
+	{ \
+		columnMin[j] = (partMin[j] < columnMin[j]) ? partMin[j] : columnMin[j]; \
+		columnMax[j] = (partMax[j] > columnMax[j]) ? partMax[j] : columnMax[j]; \
+	} \
 }
 
-int findMinInRow(Matrix a, int row)
+MATRIX_ELEMENT_TYPES(DEFINE_EXTREMA_FUNCTIONS)
+
+#ifdef MATRIX_X86_KERNELS
+/*
+ * Векторное ядро для элементов T: Vector - регистр шириной Width байт,
+ * остальные параметры - команды для этого типа. Строки выровнены, поэтому
+ * элементы строки загружаются выровненными командами.
+ */
+#define DEFINE_VECTOR_KERNEL(T, Suffix, Name, Target, Vector, Width, Set1, \
+                             Load, LoadUnaligned, StoreUnaligned, Min, Max) \
+__attribute__((target(Target))) \
+void Name(const void* rowData, int count, void* rowMin, void* rowMax, \
+          void* columnMinData, void* columnMaxData) \
+{ \
+	const T* row = (const T*)rowData; \
+	T* columnMin = (T*)columnMinData; \
+	T* columnMax = (T*)columnMaxData; \
+	const int laneCount = Width / (int)sizeof(T); \
+	Vector minVector = Set1(row[0]); \
+	Vector maxVector = minVector; \
+	int j = 0; \
+	for (; j + laneCount <= count; j += laneCount) \
+	{ \
+		Vector x = Load((const void*)(row + j)); \
+		minVector = Min(minVector, x); \
+		maxVector = Max(maxVector, x); \
+		StoreUnaligned((void*)(columnMin + j), \
+		               Min(LoadUnaligned((const void*)(columnMin + j)), x)); \
+		StoreUnaligned((void*)(columnMax + j), \
+		               Max(LoadUnaligned((const void*)(columnMax + j)), x)); \
+	} \
+	T minLanes[Width / sizeof(T)], maxLanes[Width / sizeof(T)]; \
+	StoreUnaligned((void*)minLanes, minVector); \
+	StoreUnaligned((void*)maxLanes, maxVector); \
+	T minElement = minLanes[0]; \
+	T maxElement = maxLanes[0]; \
+	for (int k = 1; k < laneCount; k++) \
+	{ \
+		minElement = (minLanes[k] < minElement) ? minLanes[k] : minElement; \
+		maxElement = (maxLanes[k] > maxElement) ? maxLanes[k] : maxElement; \
+	} \
+	updateExtremaRange##Suffix(row, j, count, &minElement, &maxElement, \
+	                           columnMin, columnMax); \
+	*(T*)rowMin = minElement; \
+	*(T*)rowMax = maxElement; \
+}
+
+DEFINE_VECTOR_KERNEL(int8_t, Int8, updateExtremaSse41Int8, "sse4.1", __m128i,
+                     16, _mm_set1_epi8, _mm_load_si128, _mm_loadu_si128,
+                     _mm_storeu_si128, _mm_min_epi8, _mm_max_epi8)
+DEFINE_VECTOR_KERNEL(int16_t, Int16, updateExtremaSse41Int16, "sse4.1",
+                     __m128i, 16, _mm_set1_epi16, _mm_load_si128,
+                     _mm_loadu_si128, _mm_storeu_si128, _mm_min_epi16,
+                     _mm_max_epi16)
+DEFINE_VECTOR_KERNEL(int, Int32, updateExtremaSse41Int32, "sse4.1", __m128i,
+                     16, _mm_set1_epi32, _mm_load_si128, _mm_loadu_si128,
+                     _mm_storeu_si128, _mm_min_epi32, _mm_max_epi32)
+DEFINE_VECTOR_KERNEL(float, Float, updateExtremaSse41Float, "sse4.1", __m128,
+                     16, _mm_set1_ps, _mm_load_ps, _mm_loadu_ps, _mm_storeu_ps,
+                     _mm_min_ps, _mm_max_ps)
+DEFINE_VECTOR_KERNEL(double, Double, updateExtremaSse41Double, "sse4.1",
+                     __m128d, 16, _mm_set1_pd, _mm_load_pd, _mm_loadu_pd,
+                     _mm_storeu_pd, _mm_min_pd, _mm_max_pd)
+
+DEFINE_VECTOR_KERNEL(int8_t, Int8, updateExtremaAvx2Int8, "avx2", __m256i, 32,
+                     _mm256_set1_epi8, _mm256_load_si256, _mm256_loadu_si256,
+                     _mm256_storeu_si256, _mm256_min_epi8, _mm256_max_epi8)
+DEFINE_VECTOR_KERNEL(int16_t, Int16, updateExtremaAvx2Int16, "avx2", __m256i,
+                     32, _mm256_set1_epi16, _mm256_load_si256,
+                     _mm256_loadu_si256, _mm256_storeu_si256,
+                     _mm256_min_epi16, _mm256_max_epi16)
+DEFINE_VECTOR_KERNEL(int, Int32, updateExtremaAvx2Int32, "avx2", __m256i, 32,
+                     _mm256_set1_epi32, _mm256_load_si256, _mm256_loadu_si256,
+                     _mm256_storeu_si256, _mm256_min_epi32, _mm256_max_epi32)
+DEFINE_VECTOR_KERNEL(float, Float, updateExtremaAvx2Float, "avx2", __m256, 32,
+                     _mm256_set1_ps, _mm256_load_ps, _mm256_loadu_ps,
+                     _mm256_storeu_ps, _mm256_min_ps, _mm256_max_ps)
+DEFINE_VECTOR_KERNEL(double, Double, updateExtremaAvx2Double, "avx2", __m256d,
+                     32, _mm256_set1_pd, _mm256_load_pd, _mm256_loadu_pd,
+                     _mm256_storeu_pd, _mm256_min_pd, _mm256_max_pd)
+
+/*
+ * Ядро выбирается один раз по возможностям процессора; без поддержки
+ * SSE4.1 и AVX2 используется обычный цикл.
+ */
+ExtremaKernel selectExtremaKernel(ExtremaKernel scalar, ExtremaKernel sse41,
+                                  ExtremaKernel avx2)
 {
-	int minElement = a.data[row][0];
-	for (int i = 1; i < a.columnCount; i++)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+	{
+		return avx2;
+	}
+	if (__builtin_cpu_supports("sse4.1"))
 	{
-		minElement = min(minElement, a.data[row][i]);
+		return sse41;
 	}
-	return minElement;
+	return scalar;
+}
+
+#define SELECT_EXTREMA_KERNEL(Suffix) \
+	selectExtremaKernel(updateExtremaScalar##Suffix, \
+	                    updateExtremaSse41##Suffix, updateExtremaAvx2##Suffix)
+#else
+#define SELECT_EXTREMA_KERNEL(Suffix) updateExtremaScalar##Suffix
+#endif
+
+int getProcessorCount(void)
+{
+#if !defined(MATRIX_THREADS)
+	return 1;
+#elif defined(_WIN32)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (info.dwNumberOfProcessors > 0) ? (int)info.dwNumberOfProcessors : 1;
+#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return (count > 0) ? (int)count : 1;
+#endif
+}
+
+#ifdef MATRIX_THREADS
+#ifdef _WIN32
+DWORD WINAPI runParallelJob(LPVOID argument)
+#else
+void* runParallelJob(void* argument)
+#endif
+{
+	ParallelJob* job = (ParallelJob*)argument;
+	job->task(job->context, job->index);
+	return 0;
 }
+#endif
 
-int findMaxInRow(Matrix a, int row)
+/*
+ * Выполняет task(context, i) для i от 0 до count - 1. При сборке с
+ * MATRIX_THREADS каждая часть выполняется в своем потоке, иначе части
+ * выполняются по очереди. Если памяти под описания потоков не хватило
+ * или поток не удалось создать, часть выполняется в вызывающем потоке.
+ */
+void runParallel(ParallelTask task, void* context, int count)
 {
-	int maxElement = a.data[row][0];
-	for (int i = 1; i < a.columnCount; i++)
+#ifdef MATRIX_THREADS
+	ParallelJob* jobs = (ParallelJob*)malloc(count * sizeof(ParallelJob));
+#ifdef _WIN32
+	HANDLE* threads = (HANDLE*)malloc(count * sizeof(HANDLE));
+	bool allocated = jobs != NULL && threads != NULL;
+#else
+	pthread_t* threads = (pthread_t*)malloc(count * sizeof(pthread_t));
+	bool* started = (bool*)malloc(count * sizeof(bool));
+	bool allocated = jobs != NULL && threads != NULL && started != NULL;
+#endif
+	if (!allocated)
+	{
+#ifndef _WIN32
+		free(started);
+#endif
+		free(threads);
+		free(jobs);
+		for (int i = 0; i < count; i++)
+		{
+			task(context, i);
+		}
+		return;
+	}
+	for (int i = 0; i < count; i++)
+	{
+		jobs[i].task = task;
+		jobs[i].context = context;
+		jobs[i].index = i;
+#ifdef _WIN32
+		threads[i] = CreateThread(NULL, 0, runParallelJob, &jobs[i], 0, NULL);
+		if (threads[i] == NULL)
+#else
+		started[i] = pthread_create(&threads[i], NULL, runParallelJob,
+		                            &jobs[i]) == 0;
+		if (!started[i])
+#endif
+		{
+			task(context, i);
+		}
+	}
+	for (int i = 0; i < count; i++)
+	{
+#ifdef _WIN32
+		if (threads[i] != NULL)
+		{
+			WaitForSingleObject(threads[i], INFINITE);
+			CloseHandle(threads[i]);
+		}
+#else
+		if (started[i])
+		{
+			pthread_join(threads[i], NULL);
+		}
+#endif
+	}
+#ifndef _WIN32
+	free(started);
+#endif
+	free(threads);
+	free(jobs);
+#else
+	for (int i = 0; i < count; i++)
 	{
-		maxElement = max(maxElement, a.data[row][i]);
+		task(context, i);
 	}
-	return maxElement;
+#endif
+}
+
+int getBandBegin(const SaddleSearch* search, int band)
+{
+	return (int)((long long)search->matrix.rowCount * band /
+	             search->bandCount);
 }
 
-int findMinInColumn(Matrix a, int col)
+/*
+ * Экстремумы строк полосы записываются сразу в общий массив (полосы не
+ * пересекаются), экстремумы столбцов - в частичные векторы полосы.
+ */
+void computeBandExtrema(void* context, int band)
 {
-	int minElement = a.data[0][col];
-	for (int i = 1; i < a.rowCount; i++)
+	SaddleSearch* search = (SaddleSearch*)context;
+	Matrix a = search->matrix;
+	size_t size = search->ops.size;
+	int begin = getBandBegin(search, band);
+	int end = getBandBegin(search, band + 1);
+	char* columnMin = (char*)search->bandColumnMin +
+	                  (size_t)band * a.columnCount * size;
+	char* columnMax = (char*)search->bandColumnMax +
+	                  (size_t)band * a.columnCount * size;
+	memcpy(columnMin, getMatrixRowData(a, begin), a.columnCount * size);
+	memcpy(columnMax, getMatrixRowData(a, begin), a.columnCount * size);
+	for (int i = begin; i < end; i++)
 	{
-		minElement = min(minElement, a.data[i][col]);
+		search->ops.kernel(getMatrixRowData(a, i), a.columnCount,
+		                   (char*)search->rowMin + (size_t)i * size,
+		                   (char*)search->rowMax + (size_t)i * size,
+		                   columnMin, columnMax);
 	}
-	return minElement;
 }
 
-int findMaxInColumn(Matrix a, int col)
+void deleteSearchExtrema(SaddleSearch* search)
+{
+	free(search->rowMin);
+	free(search->rowMax);
+	free(search->columnMin);
+	free(search->columnMax);
+	search->rowMin = NULL;
+	search->rowMax = NULL;
+	search->columnMin = NULL;
+	search->columnMax = NULL;
+}
+
+/*
+ * Минимумы и максимумы всех строк и столбцов за один проход по матрице:
+ * экстремумы столбцов обновляются построчно, поэтому матрица читается
+ * подряд, а не по столбцам. Полосы строк обрабатываются параллельно,
+ * затем частичные экстремумы столбцов объединяются.
+ */
+void computeMatrixExtrema(SaddleSearch* search)
 {
-	int maxElement = a.data[0][col];
-	for (int i = 1; i < a.rowCount; i++)
+	Matrix a = search->matrix;
+	size_t size = search->ops.size;
+	search->rowMin = malloc(a.rowCount * size);
+	search->rowMax = malloc(a.rowCount * size);
+	search->columnMin = malloc(a.columnCount * size);
+	search->columnMax = malloc(a.columnCount * size);
+	
+	size_t partialSize = (size_t)search->bandCount * a.columnCount * size;
+	search->bandColumnMin = malloc(partialSize);
+	search->bandColumnMax = malloc(partialSize);
+	if (search->rowMin == NULL || search->rowMax == NULL ||
+	    search->columnMin == NULL || search->columnMax == NULL ||
+	    search->bandColumnMin == NULL || search->bandColumnMax == NULL)
 	{
-		maxElement = max(maxElement, a.data[i][col]);
+		free(search->bandColumnMin);
+		free(search->bandColumnMax);
+		deleteSearchExtrema(search);
+		terminate("Недостаточно памяти для поиска особых элементов!");
 	}
-	return maxElement;
+	runParallel(computeBandExtrema, search, search->bandCount);
+	
+	memcpy(search->columnMin, search->bandColumnMin, a.columnCount * size);
+	memcpy(search->columnMax, search->bandColumnMax, a.columnCount * size);
+	for (int band = 1; band < search->bandCount; band++)
+	{
+		size_t offset = (size_t)band * a.columnCount * size;
+		search->ops.mergeExtrema(search->columnMin, search->columnMax,
+		                         (char*)search->bandColumnMin + offset,
+		                         (char*)search->bandColumnMax + offset,
+		                         a.columnCount);
+	}
+	free(search->bandColumnMin);
+	free(search->bandColumnMax);
+	search->bandColumnMin = NULL;
+	search->bandColumnMax = NULL;
+}
+
+void deleteMatrixExtrema(MatrixExtrema* extrema)
+{
+	free(extrema->rowMin);
+	free(extrema->rowMax);
+	free(extrema->columnMin);
+	free(extrema->columnMax);
+	extrema->rowMin = NULL;
+	extrema->rowMax = NULL;
+	extrema->columnMin = NULL;
+	extrema->columnMax = NULL;
+}
+
+bool isSpecial(MatrixExtrema extrema, int value, int row, int col)
+{
+	return ((value == extrema.rowMin[row] && value == extrema.columnMax[col]) ||
+	        (value == extrema.rowMax[row] && value == extrema.columnMin[col]));
 }
 
-bool isSpecial(Matrix a, int row, int col)
+/*
+ * Емкость массива удваивается, поэтому добавление k индексов стоит O(k)
+ * даже для матриц, в которых особые все элементы.
+ */
+void addMatrixIndex(MatrixIndexArray* array, int row, int column)
 {
-	int rowMin = findMinInRow(a, row);
-	int rowMax = findMaxInRow(a, row);
+	if (array->size == array->capacity)
+	{
+		array->capacity = (array->capacity == 0) ? 16 : 2 * array->capacity;
+		array->data = (MatrixIndex*)realloc(array->data, array->capacity * sizeof(MatrixIndex));
+		if (array->data == NULL)
+		{
+			terminate("Недостаточно памяти для списка особых элементов!");
+		}
+	}
 	
-	int colMin = findMinInColumn(a, col);
-	int colMax = findMaxInColumn(a, col);
+	MatrixIndex currentElementIndex;
+	currentElementIndex.row = row;
+	currentElementIndex.column = column;
 	
-	return ((a.data[row][col] == rowMin && a.data[row][col] == colMax) ||
-	        (a.data[row][col] == rowMax && a.data[row][col] == colMin));
+	array->data[array->size++] = currentElementIndex;
+}
+
+/*
+ * Полоса прекращает поиск, как только найдено limit элементов: в первые
+ * limit элементов всей матрицы из нее не может попасть больше. При
+ * countOnly элементы только считаются.
+ */
+#define DEFINE_BAND_SEARCH(T, Suffix, Type) \
+void findBandSpecialElements##Suffix(void* context, int band) \
+{ \
+	SaddleSearch* search = (SaddleSearch*)context; \
+	const T* rowMin = (const T*)search->rowMin; \
+	const T* rowMax = (const T*)search->rowMax; \
+	const T* columnMin = (const T*)search->columnMin; \
+	const T* columnMax = (const T*)search->columnMax; \
+	MatrixIndexArray* result = &search->bandResults[band]; \
+	result->data = NULL; \
+	result->size = 0; \
+	result->capacity = 0; \
+	size_t count = 0; \
+	 \
+	int end = getBandBegin(search, band + 1); \
+	for (int i = getBandBegin(search, band); i < end && count < search->limit; i++) \
+	{ \
+		const T* row = (const T*)getMatrixRowData(search->matrix, i); \
+		for (int j = 0; j < search->matrix.columnCount && count < search->limit; j++) \
+		{ \
+			if ((row[j] == rowMin[i] && row[j] == columnMax[j]) || \
+			    (row[j] == rowMax[i] && row[j] == columnMin[j])) \
+			{ \
+				if (!search->countOnly) \
+				{ \
+					addMatrixIndex(result, i, j); \
+				} \
+				count++; \
+			} \
+		} \
+	} \
+	search->bandCounts[band] = count; \
+}
+
+MATRIX_ELEMENT_TYPES(DEFINE_BAND_SEARCH)
+
+#define GET_ELEMENT_OPS(T, Suffix, Type) \
+	case Type: \
+		ops.size = sizeof(T); \
+		ops.kernel = SELECT_EXTREMA_KERNEL(Suffix); \
+		ops.mergeExtrema = mergeExtrema##Suffix; \
+		ops.findBandSpecialElements = findBandSpecialElements##Suffix; \
+		break;
+
+/*
+ * Тип элементов выбирается один раз на весь поиск.
+ */
+MatrixElementOps getMatrixElementOps(MatrixElementType type)
+{
+	MatrixElementOps ops;
+	switch (type)
+	{
+		MATRIX_ELEMENT_TYPES(GET_ELEMENT_OPS)
+		default:
+			terminate("Неизвестный тип элементов матрицы!");
+	}
+	return ops;
 }
 
-MatrixIndexArray findAllSpecialElements(Matrix a)
+/*
+ * Матрица делится на threadCount полос строк. Списки найденных элементов
+ * полос объединяются по порядку, поэтому результат не зависит от числа
+ * потоков. Возвращает первые limit особых элементов (при countOnly -
+ * пустой массив), в count записывается их количество.
+ */
+MatrixIndexArray searchSpecialElements(Matrix a, int threadCount, size_t limit,
+                                       bool countOnly, size_t* count)
 {
+	SaddleSearch search;
+	search.matrix = a;
+	search.ops = getMatrixElementOps(a.elementType);
+	search.bandCount = min(max(threadCount, 1), a.rowCount);
+	search.limit = limit;
+	search.countOnly = countOnly;
+	computeMatrixExtrema(&search);
+	
+	search.bandResults = (MatrixIndexArray*)malloc(search.bandCount * sizeof(MatrixIndexArray));
+	search.bandCounts = (size_t*)malloc(search.bandCount * sizeof(size_t));
+	if (search.bandResults == NULL || search.bandCounts == NULL)
+	{
+		free(search.bandResults);
+		free(search.bandCounts);
+		deleteSearchExtrema(&search);
+		terminate("Недостаточно памяти для поиска особых элементов!");
+	}
+	runParallel(search.ops.findBandSpecialElements, &search, search.bandCount);
+	deleteSearchExtrema(&search);
+	
+	*count = 0;
+	for (int band = 0; band < search.bandCount; band++)
+	{
+		*count += search.bandCounts[band];
+	}
+	if (*count > limit)
+	{
+		*count = limit;
+	}
+	
 	MatrixIndexArray result;
+	result.data = NULL;
 	result.size = 0;
-	
-	for (int i = 0; i < a.rowCount; i++)
+	result.capacity = 0;
+	if (!countOnly && *count != 0)
 	{
-		for (int j = 0; j < a.columnCount; j++)
+		result.data = (MatrixIndex*)malloc(*count * sizeof(MatrixIndex));
+		if (result.data == NULL)
 		{
-			if (isSpecial(a, i, j))
-			{
-				if (result.size == 0)
-				{
-					result.data = (MatrixIndex*)malloc(++result.size * sizeof(MatrixIndex));
-				}
-				else
-				{
-					result.data = (MatrixIndex*)realloc(result.data, ++result.size * sizeof(MatrixIndex));
-				}
-				
-				MatrixIndex currentElementIndex;
-				currentElementIndex.row = i;
-				currentElementIndex.column = j;
-				
-				result.data[result.size - 1] = currentElementIndex;
-			}
+			terminate("Недостаточно памяти для списка особых элементов!");
+		}
+		result.capacity = *count;
+	}
+	for (int band = 0; band < search.bandCount; band++)
+	{
+		MatrixIndexArray part = search.bandResults[band];
+		size_t size = result.capacity - result.size;
+		if (size > part.size)
+		{
+			size = part.size;
+		}
+		if (size != 0)
+		{
+			memcpy(result.data + result.size, part.data, size * sizeof(MatrixIndex));
+			result.size += size;
 		}
+		free(part.data);
 	}
+	free(search.bandResults);
+	free(search.bandCounts);
 	
 	return result;
 }
 
-int main()
+MatrixIndexArray findAllSpecialElements(Matrix a, int threadCount)
 {
-	setlocale(LC_ALL, "rus");
-	
-	printf("Введите количество строк матрицы n: ");
-	int n, m;
-	if (!scanf("%d", &n) || n <= 0)
+	size_t count;
+	return searchSpecialElements(a, threadCount, SIZE_MAX, false, &count);
+}
+
+MatrixIndexArray findFirstSpecialElements(Matrix a, int threadCount,
+                                          size_t limit)
+{
+	size_t count;
+	return searchSpecialElements(a, threadCount, limit, false, &count);
+}
+
+size_t countSpecialElements(Matrix a, int threadCount)
+{
+	size_t count;
+	searchSpecialElements(a, threadCount, SIZE_MAX, true, &count);
+	return count;
+}
+
+size_t getTreeLeafCount(int count)
+{
+	size_t leafCount = 1;
+	while (leafCount < (size_t)count)
 	{
-		terminate("Введите корректное значние размера!");
+		leafCount *= 2;
 	}
-	
-	printf("Введите количество столбцов матрицы m: ");
-	if (!scanf("%d", &m) || m <= 0)
+	return leafCount;
+}
+
+ExtremaNode* getRowTree(const DynamicMatrix* a, int row)
+{
+	return a->rowTrees + (size_t)row * 2 * a->rowLeafCount;
+}
+
+ExtremaNode* getColumnTree(const DynamicMatrix* a, int column)
+{
+	return a->columnTrees + (size_t)column * 2 * a->columnLeafCount;
+}
+
+void buildExtremaTree(ExtremaNode* tree, size_t leafCount)
+{
+	for (size_t node = leafCount - 1; node >= 1; node--)
 	{
-		terminate("Введите корректное значние размера!");
+		tree[node].min = min(tree[2 * node].min, tree[2 * node + 1].min);
+		tree[node].max = max(tree[2 * node].max, tree[2 * node + 1].max);
+	}
+}
+
+void updateExtremaTree(ExtremaNode* tree, size_t leafCount, int index,
+                       int value)
+{
+	size_t node = leafCount + index;
+	tree[node].min = value;
+	tree[node].max = value;
+	for (node /= 2; node >= 1; node /= 2)
+	{
+		tree[node].min = min(tree[2 * node].min, tree[2 * node + 1].min);
+		tree[node].max = max(tree[2 * node].max, tree[2 * node + 1].max);
+	}
+}
+
+int getDynamicElement(const DynamicMatrix* a, int row, int column)
+{
+	return getRowTree(a, row)[a->rowLeafCount + column].min;
+}
+
+bool isDynamicSpecial(const DynamicMatrix* a, int row, int column)
+{
+	int value = getDynamicElement(a, row, column);
+	ExtremaNode rowExtrema = getRowTree(a, row)[1];
+	ExtremaNode columnExtrema = getColumnTree(a, column)[1];
+	return ((value == rowExtrema.min && value == columnExtrema.max) ||
+	        (value == rowExtrema.max && value == columnExtrema.min));
+}
+
+bool getSpecialFlag(const DynamicMatrix* a, int row, int column)
+{
+	size_t index = (size_t)row * a->columnCount + column;
+	return (a->special[index / 64] >> (index % 64)) & 1;
+}
+
+void flipSpecialFlag(DynamicMatrix* a, int row, int column)
+{
+	size_t index = (size_t)row * a->columnCount + column;
+	a->special[index / 64] ^= (uint64_t)1 << (index % 64);
+}
+
+void createDynamicMatrix(DynamicMatrix* a, Matrix source)
+{
+	a->rowCount = source.rowCount;
+	a->columnCount = source.columnCount;
+	a->rowLeafCount = getTreeLeafCount(source.columnCount);
+	a->columnLeafCount = getTreeLeafCount(source.rowCount);
+	size_t cellCount = (size_t)source.rowCount * source.columnCount;
+	a->rowTrees = (ExtremaNode*)malloc((size_t)source.rowCount * 2 * a->rowLeafCount * sizeof(ExtremaNode));
+	a->columnTrees = (ExtremaNode*)malloc((size_t)source.columnCount * 2 * a->columnLeafCount * sizeof(ExtremaNode));
+	a->special = (uint64_t*)calloc((cellCount + 63) / 64, sizeof(uint64_t));
+	if (a->rowTrees == NULL || a->columnTrees == NULL || a->special == NULL)
+	{
+		terminate("Недостаточно памяти для изменяемой матрицы!");
 	}
 	
-	Matrix a;
-	createMatrix(&a, n, m);
-	
-	puts("Введите матрицу размером n*m:");
-	for (int i = 0; i < n; i++)
+	for (int i = 0; i < a->rowCount; i++)
 	{
-		for (int j = 0; j < m; j++)
+		ExtremaNode* tree = getRowTree(a, i);
+		for (size_t j = 0; j < a->rowLeafCount; j++)
 		{
-			scanf("%d", &a.data[i][j]);
+			tree[a->rowLeafCount + j].min = INT_MAX;
+			tree[a->rowLeafCount + j].max = INT_MIN;
 		}
 	}
-	
-	puts("Индексы всех \"особых\" элементов матрицы:");
-	MatrixIndexArray answer = findAllSpecialElements(a);
-	for (int i = 0; i < answer.size; i++)
+	for (int j = 0; j < a->columnCount; j++)
 	{
-		printf("[%d, %d]", answer.data[i].row + 1, answer.data[i].column + 1);
-		if (i + 1 != answer.size)
+		ExtremaNode* tree = getColumnTree(a, j);
+		for (size_t i = 0; i < a->columnLeafCount; i++)
 		{
-			printf("; ");
+			tree[a->columnLeafCount + i].min = INT_MAX;
+			tree[a->columnLeafCount + i].max = INT_MIN;
 		}
 	}
-	puts("");
+	for (int i = 0; i < a->rowCount; i++)
+	{
+		const int* row = getMatrixRow(source, i);
+		ExtremaNode* rowTree = getRowTree(a, i);
+		for (int j = 0; j < a->columnCount; j++)
+		{
+			rowTree[a->rowLeafCount + j].min = row[j];
+			rowTree[a->rowLeafCount + j].max = row[j];
+			ExtremaNode* columnTree = getColumnTree(a, j);
+			columnTree[a->columnLeafCount + i].min = row[j];
+			columnTree[a->columnLeafCount + i].max = row[j];
+		}
+		buildExtremaTree(rowTree, a->rowLeafCount);
+	}
+	for (int j = 0; j < a->columnCount; j++)
+	{
+		buildExtremaTree(getColumnTree(a, j), a->columnLeafCount);
+	}
 	
-	answer.size = 0;
-	free(answer.data);
-	answer.data = NULL;
+	a->specialCount = 0;
+	for (int i = 0; i < a->rowCount; i++)
+	{
+		for (int j = 0; j < a->columnCount; j++)
+		{
+			if (isDynamicSpecial(a, i, j))
+			{
+				flipSpecialFlag(a, i, j);
+				a->specialCount++;
+			}
+		}
+	}
+	a->added.data = NULL;
+	a->added.size = 0;
+	a->added.capacity = 0;
+	a->removed = a->added;
+}
+
+void deleteDynamicMatrix(DynamicMatrix* a)
+{
+	free(a->rowTrees);
+	free(a->columnTrees);
+	free(a->special);
+	free(a->added.data);
+	free(a->removed.data);
+	a->rowTrees = NULL;
+	a->columnTrees = NULL;
+	a->special = NULL;
+	a->added.data = NULL;
+	a->removed.data = NULL;
+}
+
+/*
+ * Пересчитывает, является ли элемент особым, и записывает изменение.
+ */
+void checkDynamicElement(DynamicMatrix* a, int row, int column)
+{
+	bool special = isDynamicSpecial(a, row, column);
+	if (special == getSpecialFlag(a, row, column))
+	{
+		return;
+	}
+	flipSpecialFlag(a, row, column);
+	if (special)
+	{
+		a->specialCount++;
+		addMatrixIndex(&a->added, row, column);
+	}
+	else
+	{
+		a->specialCount--;
+		addMatrixIndex(&a->removed, row, column);
+	}
+}
+
+/*
+ * Проверяет элементы строки (isRow) или столбца line, равные value -
+ * прежнему или новому минимуму линии (при maximum - максимуму). Все
+ * элементы линии, кроме измененного элемента changed, не меньше обоих
+ * минимумов, поэтому поддерево без changed содержит элемент, равный
+ * value, тогда и только тогда, когда его минимум равен value. Обход
+ * посещает O((k + 1) log) узлов, где k - число найденных элементов.
+ */
+void checkEqualElements(DynamicMatrix* a, bool isRow, int line, int changed,
+                        int value, bool maximum, size_t node, size_t begin,
+                        size_t end)
+{
+	const ExtremaNode* tree = isRow ? getRowTree(a, line)
+	                                : getColumnTree(a, line);
+	size_t count = isRow ? (size_t)a->columnCount : (size_t)a->rowCount;
+	int key = maximum ? tree[node].max : tree[node].min;
+	bool containsChanged = begin <= (size_t)changed && (size_t)changed < end;
+	if (begin >= count || (key != value && !containsChanged))
+	{
+		return;
+	}
+	if (end - begin == 1)
+	{
+		checkDynamicElement(a, isRow ? line : (int)begin,
+		                    isRow ? (int)begin : line);
+		return;
+	}
+	size_t middle = begin + (end - begin) / 2;
+	checkEqualElements(a, isRow, line, changed, value, maximum, 2 * node,
+	                   begin, middle);
+	checkEqualElements(a, isRow, line, changed, value, maximum, 2 * node + 1,
+	                   middle, end);
+}
+
+/*
+ * Если экстремум линии изменился, особыми могли стать или перестать быть
+ * только элементы линии, равные прежнему или новому экстремуму.
+ */
+void checkChangedExtremum(DynamicMatrix* a, bool isRow, int line, int changed,
+                          int oldValue, int newValue, bool maximum)
+{
+	if (oldValue == newValue)
+	{
+		return;
+	}
+	size_t leafCount = isRow ? a->rowLeafCount : a->columnLeafCount;
+	checkEqualElements(a, isRow, line, changed, oldValue, maximum, 1, 0,
+	                   leafCount);
+	checkEqualElements(a, isRow, line, changed, newValue, maximum, 1, 0,
+	                   leafCount);
+}
+
+/*
+ * Изменяет элемент за O(log n + log m) и пересчитывает только те
+ * элементы его строки и столбца, которые могли изменить свой статус:
+ * экстремумы остальных строк и столбцов не меняются.
+ */
+void setDynamicElement(DynamicMatrix* a, int row, int column, int value)
+{
+	a->added.size = 0;
+	a->removed.size = 0;
+	if (getDynamicElement(a, row, column) == value)
+	{
+		return;
+	}
+	
+	ExtremaNode* rowTree = getRowTree(a, row);
+	ExtremaNode* columnTree = getColumnTree(a, column);
+	ExtremaNode oldRow = rowTree[1];
+	ExtremaNode oldColumn = columnTree[1];
+	updateExtremaTree(rowTree, a->rowLeafCount, column, value);
+	updateExtremaTree(columnTree, a->columnLeafCount, row, value);
+	
+	checkDynamicElement(a, row, column);
+	checkChangedExtremum(a, true, row, column, oldRow.min, rowTree[1].min, false);
+	checkChangedExtremum(a, true, row, column, oldRow.max, rowTree[1].max, true);
+	checkChangedExtremum(a, false, column, row, oldColumn.min, columnTree[1].min, false);
+	checkChangedExtremum(a, false, column, row, oldColumn.max, columnTree[1].max, true);
+}
+
+bool seekFile(FILE* file, uint64_t offset)
+{
+#ifdef _WIN32
+	return _fseeki64(file, (__int64)offset, SEEK_SET) == 0;
+#else
+	return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+uint64_t tellFile(FILE* file)
+{
+#ifdef _WIN32
+	return (uint64_t)_ftelli64(file);
+#else
+	return (uint64_t)ftello(file);
+#endif
+}
+
+uint64_t getFileSize(FILE* file)
+{
+#ifdef _WIN32
+	_fseeki64(file, 0, SEEK_END);
+#else
+	fseeko(file, 0, SEEK_END);
+#endif
+	return tellFile(file);
+}
+
+bool isInteractiveInput(void)
+{
+#ifdef _WIN32
+	return _isatty(_fileno(stdin));
+#else
+	return isatty(fileno(stdin));
+#endif
+}
+
+void openIntegerReader(IntegerReader* reader, FILE* stream, uint64_t offset)
+{
+	reader->stream = stream;
+	reader->buffer = (char*)malloc(READER_BUFFER_SIZE);
+	if (reader->buffer == NULL)
+	{
+		terminate("Недостаточно памяти для чтения матрицы!");
+	}
+	reader->size = 0;
+	reader->position = 0;
+	reader->bufferOffset = offset;
+	reader->failed = false;
+}
+
+void closeIntegerReader(IntegerReader* reader)
+{
+	free(reader->buffer);
+	reader->buffer = NULL;
+}
+
+uint64_t getReaderOffset(const IntegerReader* reader)
+{
+	return reader->bufferOffset + reader->position;
+}
+
+/*
+ * Возвращает следующий байт, не продвигаясь, или -1 в конце файла.
+ */
+int peekByte(IntegerReader* reader)
+{
+	if (reader->position == reader->size)
+	{
+		reader->bufferOffset += reader->size;
+		reader->size = fread(reader->buffer, 1, READER_BUFFER_SIZE,
+		                     reader->stream);
+		reader->position = 0;
+		if (reader->size == 0)
+		{
+			return -1;
+		}
+	}
+	return (unsigned char)reader->buffer[reader->position];
+}
+
+bool isSpaceByte(int c)
+{
+	return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' ||
+	       c == '\f';
+}
+
+/*
+ * Пропускает пробельные символы; возвращает false в конце файла.
+ */
+bool skipSpaces(IntegerReader* reader)
+{
+	int c;
+	while ((c = peekByte(reader)) != -1 && isSpaceByte(c))
+	{
+		reader->position++;
+	}
+	return c != -1;
+}
+
+void skipToken(IntegerReader* reader)
+{
+	int c;
+	while ((c = peekByte(reader)) != -1 && !isSpaceByte(c))
+	{
+		reader->position++;
+	}
+}
+
+/*
+ * Читает число со знаком в десятичной записи, отделенное пробельными
+ * символами. Возвращает false в конце файла, а для числа с посторонними
+ * символами или вне диапазона int также устанавливает reader->failed.
+ */
+bool readInteger(IntegerReader* reader, int* value)
+{
+	if (!skipSpaces(reader))
+	{
+		return false;
+	}
+	int c = peekByte(reader);
+	bool negative = c == '-';
+	if (c == '-' || c == '+')
+	{
+		reader->position++;
+	}
+	unsigned long long limit = negative ? (unsigned long long)INT_MAX + 1
+	                                    : (unsigned long long)INT_MAX;
+	unsigned long long result = 0;
+	int digitCount = 0;
+	while ((c = peekByte(reader)) >= '0' && c <= '9')
+	{
+		result = result * 10 + (unsigned long long)(c - '0');
+		if (result > limit)
+		{
+			reader->failed = true;
+			return false;
+		}
+		reader->position++;
+		digitCount++;
+	}
+	if (digitCount == 0 || (c != -1 && !isSpaceByte(c)))
+	{
+		reader->failed = true;
+		return false;
+	}
+	*value = negative ? (int)(-(long long)result) : (int)result;
+	return true;
+}
+
+bool readMatrixRow(IntegerReader* reader, int* row, int count)
+{
+	for (int j = 0; j < count; j++)
+	{
+		if (!readInteger(reader, &row[j]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool readMatrixSize(IntegerReader* reader, int* n, int* m)
+{
+	return readInteger(reader, n) && readInteger(reader, m) && *n > 0 &&
+	       *m > 0;
+}
+
+/*
+ * Читает вещественное число (в записи strtod), отделенное пробельными
+ * символами; NaN считается некорректным значением.
+ */
+bool readReal(IntegerReader* reader, double* value)
+{
+	if (!skipSpaces(reader))
+	{
+		return false;
+	}
+	char token[64];
+	size_t length = 0;
+	int c;
+	while ((c = peekByte(reader)) != -1 && !isSpaceByte(c))
+	{
+		if (length + 1 == sizeof(token))
+		{
+			reader->failed = true;
+			return false;
+		}
+		token[length++] = (char)c;
+		reader->position++;
+	}
+	token[length] = '\0';
+	char* end;
+	*value = strtod(token, &end);
+	if (end != token + length || *value != *value)
+	{
+		reader->failed = true;
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Читает элемент column строки row типа type. Целые числа вне диапазона
+ * типа считаются некорректными.
+ */
+bool readMatrixElement(IntegerReader* reader, MatrixElementType type,
+                       void* row, int column)
+{
+	int value;
+	double real;
+	switch (type)
+	{
+		case MATRIX_ELEMENT_INT8:
+			if (!readInteger(reader, &value) || value < INT8_MIN ||
+			    value > INT8_MAX)
+			{
+				return false;
+			}
+			((int8_t*)row)[column] = (int8_t)value;
+			return true;
+		case MATRIX_ELEMENT_INT16:
+			if (!readInteger(reader, &value) || value < INT16_MIN ||
+			    value > INT16_MAX)
+			{
+				return false;
+			}
+			((int16_t*)row)[column] = (int16_t)value;
+			return true;
+		case MATRIX_ELEMENT_FLOAT:
+			if (!readReal(reader, &real))
+			{
+				return false;
+			}
+			((float*)row)[column] = (float)real;
+			return true;
+		case MATRIX_ELEMENT_DOUBLE:
+			if (!readReal(reader, &real))
+			{
+				return false;
+			}
+			((double*)row)[column] = real;
+			return true;
+		default:
+			return readInteger(reader, &((int*)row)[column]);
+	}
+}
+
+uint64_t getChunkBegin(const TextMatrixLoad* load, int chunk)
+{
+	return load->dataBegin + (load->fileSize - load->dataBegin) *
+	                         (uint64_t)chunk / (uint64_t)load->chunkCount;
+}
+
+/*
+ * Устанавливает чтение на начало части. Если часть начинается внутри
+ * числа, это число пропускается: оно относится к предыдущей части.
+ */
+bool openChunkReader(const TextMatrixLoad* load, int chunk,
+                     IntegerReader* reader)
+{
+	FILE* file = fopen(load->fileName, "rb");
+	if (file == NULL)
+	{
+		return false;
+	}
+	uint64_t begin = getChunkBegin(load, chunk);
+	uint64_t offset = (chunk > 0) ? begin - 1 : begin;
+	openIntegerReader(reader, file, offset);
+	if (!seekFile(file, offset))
+	{
+		closeIntegerReader(reader);
+		fclose(file);
+		return false;
+	}
+	if (chunk > 0)
+	{
+		int previous = peekByte(reader);
+		reader->position++;
+		if (previous != -1 && !isSpaceByte(previous))
+		{
+			skipToken(reader);
+		}
+	}
+	return true;
+}
+
+void closeChunkReader(IntegerReader* reader)
+{
+	fclose(reader->stream);
+	closeIntegerReader(reader);
+}
+
+void countChunkIntegers(void* context, int chunk)
+{
+	TextMatrixLoad* load = (TextMatrixLoad*)context;
+	IntegerReader reader;
+	load->firstIndices[chunk + 1] = 0;
+	if (!openChunkReader(load, chunk, &reader))
+	{
+		load->failures[chunk] = true;
+		return;
+	}
+	uint64_t end = getChunkBegin(load, chunk + 1);
+	size_t count = 0;
+	while (skipSpaces(&reader) && getReaderOffset(&reader) < end)
+	{
+		skipToken(&reader);
+		count++;
+	}
+	load->firstIndices[chunk + 1] = count;
+	closeChunkReader(&reader);
+}
+
+void parseChunkIntegers(void* context, int chunk)
+{
+	TextMatrixLoad* load = (TextMatrixLoad*)context;
+	IntegerReader reader;
+	if (!openChunkReader(load, chunk, &reader))
+	{
+		load->failures[chunk] = true;
+		return;
+	}
+	Matrix a = load->matrix;
+	size_t total = (size_t)a.rowCount * a.columnCount;
+	size_t last = (load->firstIndices[chunk + 1] < total)
+	              ? load->firstIndices[chunk + 1] : total;
+	size_t index = load->firstIndices[chunk];
+	uint64_t end = getChunkBegin(load, chunk + 1);
+	while (index < last && skipSpaces(&reader) &&
+	       getReaderOffset(&reader) < end)
+	{
+		if (!readInteger(&reader, &getMatrixRow(a, (int)(index / a.columnCount))
+		                                       [index % a.columnCount]))
+		{
+			load->failures[chunk] = true;
+			break;
+		}
+		index++;
+	}
+	if (index < last)
+	{
+		load->failures[chunk] = true;
+	}
+	closeChunkReader(&reader);
+}
+
+/*
+ * Загружает текстовую матрицу из файла; при threadCount > 1 файл
+ * разбирается по частям параллельно (см. TextMatrixLoad).
+ */
+void loadTextMatrix(const char* fileName, int threadCount, Matrix* a)
+{
+	FILE* file = fopen(fileName, "rb");
+	if (file == NULL)
+	{
+		terminate("Не удалось открыть файл матрицы!");
+	}
+	IntegerReader reader;
+	openIntegerReader(&reader, file, 0);
+	int n, m;
+	if (!readMatrixSize(&reader, &n, &m))
+	{
+		terminate("Введите корректное значние размера!");
+	}
+	TextMatrixLoad load;
+	load.fileName = fileName;
+	load.dataBegin = getReaderOffset(&reader);
+	load.fileSize = getFileSize(file);
+	closeIntegerReader(&reader);
+	fclose(file);
+	
+	createMatrix(a, MATRIX_ELEMENT_INT32, n, m);
+	load.matrix = *a;
+	load.chunkCount = max(threadCount, 1);
+	if ((uint64_t)load.chunkCount > load.fileSize - load.dataBegin)
+	{
+		load.chunkCount = 1;
+	}
+	load.firstIndices = (size_t*)calloc(load.chunkCount + 1, sizeof(size_t));
+	load.failures = (bool*)calloc(load.chunkCount, sizeof(bool));
+	if (load.firstIndices == NULL || load.failures == NULL)
+	{
+		terminate("Недостаточно памяти для загрузки матрицы!");
+	}
+	size_t total = (size_t)n * m;
+	if (load.chunkCount > 1)
+	{
+		runParallel(countChunkIntegers, &load, load.chunkCount);
+		for (int chunk = 0; chunk < load.chunkCount; chunk++)
+		{
+			load.firstIndices[chunk + 1] += load.firstIndices[chunk];
+		}
+	}
+	else
+	{
+		load.firstIndices[1] = total;
+	}
+	bool failed = load.firstIndices[load.chunkCount] < total;
+	if (!failed)
+	{
+		runParallel(parseChunkIntegers, &load, load.chunkCount);
+		for (int chunk = 0; chunk < load.chunkCount; chunk++)
+		{
+			failed = failed || load.failures[chunk];
+		}
+	}
+	free(load.firstIndices);
+	free(load.failures);
+	if (failed)
+	{
+		terminate("Матрица неполная или содержит некорректные значения!");
+	}
+}
+
+void printMatrixIndex(int row, int column, bool first)
+{
+	printf("%s[%d, %d]", first ? "" : "; ", row + 1, column + 1);
+}
+
+void printSpecialElementCount(size_t count)
+{
+	printf("Количество \"особых\" элементов матрицы: %zu\n", count);
+}
+
+/*
+ * Поиск без загрузки матрицы в память. Первый проход читает матрицу по
+ * строкам и считает экстремумы строк и текущие экстремумы столбцов,
+ * второй проход читает матрицу еще раз и проверяет каждый элемент. Если
+ * входной поток нельзя перечитать (канал), строки первого прохода
+ * сохраняются во временный файл в двоичном виде. В памяти находятся
+ * только одна строка и векторы экстремумов длины n и m.
+ */
+void findSpecialElementsInStream(FILE* input, size_t limit, bool countOnly)
+{
+	bool seekable = fseek(input, 0, SEEK_CUR) == 0;
+	IntegerReader reader;
+	openIntegerReader(&reader, input, seekable ? tellFile(input) : 0);
+	int n, m;
+	if (!readMatrixSize(&reader, &n, &m))
+	{
+		terminate("Введите корректное значние размера!");
+	}
+	uint64_t start = getReaderOffset(&reader);
+	FILE* spill = NULL;
+	if (!seekable)
+	{
+		spill = tmpfile();
+		if (spill == NULL)
+		{
+			terminate("Не удалось создать временный файл!");
+		}
+	}
+	
+	MatrixExtrema extrema;
+	extrema.rowMin = (int*)malloc(n * sizeof(int));
+	extrema.rowMax = (int*)malloc(n * sizeof(int));
+	extrema.columnMin = (int*)malloc(m * sizeof(int));
+	extrema.columnMax = (int*)malloc(m * sizeof(int));
+	int* row = (int*)allocateAligned(m * sizeof(int));
+	if (extrema.rowMin == NULL || extrema.rowMax == NULL ||
+	    extrema.columnMin == NULL || extrema.columnMax == NULL || row == NULL)
+	{
+		deleteMatrixExtrema(&extrema);
+		freeAligned(row);
+		if (spill != NULL)
+		{
+			fclose(spill);
+		}
+		terminate("Недостаточно памяти для матрицы такого размера!");
+	}
+	ExtremaKernel kernel = getMatrixElementOps(MATRIX_ELEMENT_INT32).kernel;
+	for (int i = 0; i < n; i++)
+	{
+		if (!readMatrixRow(&reader, row, m))
+		{
+			terminate("Матрица неполная или содержит некорректные значения!");
+		}
+		if (i == 0)
+		{
+			memcpy(extrema.columnMin, row, m * sizeof(int));
+			memcpy(extrema.columnMax, row, m * sizeof(int));
+		}
+		kernel(row, m, &extrema.rowMin[i], &extrema.rowMax[i],
+		       extrema.columnMin, extrema.columnMax);
+		if (spill != NULL && fwrite(row, sizeof(int), m, spill) != (size_t)m)
+		{
+			terminate("Не удалось записать временный файл!");
+		}
+	}
+	
+	if (spill != NULL)
+	{
+		rewind(spill);
+	}
+	else
+	{
+		closeIntegerReader(&reader);
+		openIntegerReader(&reader, input, start);
+		if (!seekFile(input, start))
+		{
+			terminate("Не удалось перечитать матрицу!");
+		}
+	}
+	if (!countOnly)
+	{
+		puts("Индексы всех \"особых\" элементов матрицы:");
+	}
+	size_t count = 0;
+	for (int i = 0; i < n && count < limit; i++)
+	{
+		bool read = (spill != NULL)
+		            ? fread(row, sizeof(int), m, spill) == (size_t)m
+		            : readMatrixRow(&reader, row, m);
+		if (!read)
+		{
+			terminate("Не удалось перечитать матрицу!");
+		}
+		for (int j = 0; j < m && count < limit; j++)
+		{
+			if (isSpecial(extrema, row[j], i, j))
+			{
+				if (!countOnly)
+				{
+					printMatrixIndex(i, j, count == 0);
+				}
+				count++;
+			}
+		}
+	}
+	if (countOnly)
+	{
+		printSpecialElementCount(count);
+	}
+	else
+	{
+		puts("");
+	}
+	
+	if (spill != NULL)
+	{
+		fclose(spill);
+	}
+	closeIntegerReader(&reader);
+	freeAligned(row);
+	deleteMatrixExtrema(&extrema);
+}
+
+/*
+ * Записывает матрицу из текстового файла в двоичный с элементами типа
+ * type.
+ */
+void convertMatrixFile(const char* textFileName, const char* binaryFileName,
+                       MatrixElementType type)
+{
+	FILE* input = fopen(textFileName, "rb");
+	if (input == NULL)
+	{
+		terminate("Не удалось открыть файл матрицы!");
+	}
+	IntegerReader reader;
+	openIntegerReader(&reader, input, 0);
+	int n, m;
+	if (!readMatrixSize(&reader, &n, &m))
+	{
+		terminate("Введите корректное значние размера!");
+	}
+	
+	MatrixFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.signature, MATRIX_FILE_SIGNATURE, sizeof(header.signature));
+	size_t elementSize = getMatrixElementSize(type);
+	header.elementType = type;
+	header.rowCount = (uint64_t)n;
+	header.columnCount = (uint64_t)m;
+	header.stride = getMatrixStride(m, elementSize);
+	header.dataOffset = sizeof(header);
+	
+	void* row = calloc(header.stride, elementSize);
+	if (row == NULL)
+	{
+		terminate("Недостаточно памяти для строки матрицы!");
+	}
+	FILE* output = fopen(binaryFileName, "wb");
+	if (output == NULL)
+	{
+		terminate("Не удалось создать двоичный файл матрицы!");
+	}
+	fwrite(&header, sizeof(header), 1, output);
+	
+	for (int i = 0; i < n; i++)
+	{
+		for (int j = 0; j < m; j++)
+		{
+			if (!readMatrixElement(&reader, type, row, j))
+			{
+				terminate("Матрица неполная или содержит некорректные значения!");
+			}
+		}
+		fwrite(row, elementSize, header.stride, output);
+	}
+	free(row);
+	closeIntegerReader(&reader);
+	fclose(input);
+	if (ferror(output) || fclose(output) != 0)
+	{
+		terminate("Не удалось записать двоичный файл матрицы!");
+	}
+	puts("Матрица записана в двоичный файл.");
+}
+
+/*
+ * Отображает двоичный файл матрицы в память только для чтения; элементы
+ * не копируются и подгружаются с диска по мере обращения к ним.
+ */
+void mapMatrixFile(const char* fileName, MappedMatrix* file)
+{
+#ifdef _WIN32
+	HANDLE handle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL,
+	                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	LARGE_INTEGER size;
+	if (handle == INVALID_HANDLE_VALUE || !GetFileSizeEx(handle, &size))
+	{
+		terminate("Не удалось открыть двоичный файл матрицы!");
+	}
+	file->size = (size_t)size.QuadPart;
+	HANDLE mapping = (file->size >= sizeof(MatrixFileHeader))
+	                 ? CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL)
+	                 : NULL;
+	file->mapping = (mapping != NULL)
+	                ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+	if (mapping != NULL)
+	{
+		CloseHandle(mapping);
+	}
+	CloseHandle(handle);
+	if (file->mapping == NULL)
+	{
+		terminate("Не удалось отобразить двоичный файл матрицы в память!");
+	}
+#else
+	int descriptor = open(fileName, O_RDONLY);
+	struct stat status;
+	if (descriptor < 0 || fstat(descriptor, &status) != 0)
+	{
+		terminate("Не удалось открыть двоичный файл матрицы!");
+	}
+	file->size = (size_t)status.st_size;
+	file->mapping = (file->size >= sizeof(MatrixFileHeader))
+	                ? mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, descriptor, 0)
+	                : MAP_FAILED;
+	close(descriptor);
+	if (file->mapping == MAP_FAILED)
+	{
+		terminate("Не удалось отобразить двоичный файл матрицы в память!");
+	}
+#endif
+	
+	const MatrixFileHeader* header = (const MatrixFileHeader*)file->mapping;
+	size_t elementSize = getMatrixElementSize((MatrixElementType)header->elementType);
+	if (memcmp(header->signature, MATRIX_FILE_SIGNATURE,
+	           sizeof(header->signature)) != 0 || elementSize == 0)
+	{
+		terminate("Файл не является двоичным файлом матрицы!");
+	}
+	if (header->rowCount == 0 || header->rowCount > INT_MAX ||
+	    header->columnCount == 0 || header->columnCount > INT_MAX ||
+	    header->stride < header->columnCount ||
+	    header->stride % (MATRIX_ALIGNMENT / elementSize) != 0 ||
+	    header->stride > SIZE_MAX / elementSize / header->rowCount ||
+	    header->dataOffset % MATRIX_ALIGNMENT != 0 ||
+	    header->dataOffset > file->size ||
+	    header->rowCount * header->stride * elementSize >
+	    file->size - header->dataOffset)
+	{
+		terminate("Двоичный файл матрицы поврежден!");
+	}
+	file->matrix.data = (char*)file->mapping + header->dataOffset;
+	file->matrix.elementType = (MatrixElementType)header->elementType;
+	file->matrix.rowCount = (int)header->rowCount;
+	file->matrix.columnCount = (int)header->columnCount;
+	file->matrix.stride = (size_t)header->stride;
+}
+
+void unmapMatrixFile(MappedMatrix* file)
+{
+#ifdef _WIN32
+	UnmapViewOfFile(file->mapping);
+#else
+	munmap(file->mapping, file->size);
+#endif
+	file->mapping = NULL;
+	file->size = 0;
+	file->matrix.data = NULL;
+}
+
+void printSpecialElements(MatrixIndexArray answer)
+{
+	puts("Индексы всех \"особых\" элементов матрицы:");
+	for (size_t i = 0; i < answer.size; i++)
+	{
+		printMatrixIndex(answer.data[i].row, answer.data[i].column, i == 0);
+	}
+	puts("");
+}
+
+void printMatrixChanges(const DynamicMatrix* a)
+{
+	for (size_t i = 0; i < a->added.size; i++)
+	{
+		printf("%s+[%d, %d]", (i == 0) ? "" : "; ",
+		       a->added.data[i].row + 1, a->added.data[i].column + 1);
+	}
+	for (size_t i = 0; i < a->removed.size; i++)
+	{
+		printf("%s-[%d, %d]", (a->added.size + i == 0) ? "" : "; ",
+		       a->removed.data[i].row + 1, a->removed.data[i].column + 1);
+	}
+	puts("");
+}
+
+/*
+ * Применяет к матрице изменения "i j v" из файла (нумерация с 1). Сначала
+ * выводятся все особые элементы, затем после каждого изменения - строка
+ * с элементами, ставшими (+) и переставшими быть (-) особыми, или при
+ * countOnly - их количество.
+ */
+void applyMatrixUpdates(Matrix source, const char* fileName, bool countOnly)
+{
+	if (source.elementType != MATRIX_ELEMENT_INT32)
+	{
+		terminate("Изменения поддерживаются только для матриц с элементами int!");
+	}
+	FILE* input = fopen(fileName, "r");
+	if (input == NULL)
+	{
+		terminate("Не удалось открыть файл изменений!");
+	}
+	DynamicMatrix a;
+	createDynamicMatrix(&a, source);
+	
+	if (countOnly)
+	{
+		printSpecialElementCount(a.specialCount);
+	}
+	else
+	{
+		puts("Индексы всех \"особых\" элементов матрицы:");
+		bool first = true;
+		for (int i = 0; i < a.rowCount; i++)
+		{
+			for (int j = 0; j < a.columnCount; j++)
+			{
+				if (getSpecialFlag(&a, i, j))
+				{
+					printMatrixIndex(i, j, first);
+					first = false;
+				}
+			}
+		}
+		puts("");
+	}
+	
+	IntegerReader reader;
+	openIntegerReader(&reader, input, 0);
+	int row, column, value;
+	while (readInteger(&reader, &row))
+	{
+		if (!readInteger(&reader, &column) || !readInteger(&reader, &value) ||
+		    row < 1 || row > a.rowCount || column < 1 ||
+		    column > a.columnCount)
+		{
+			terminate("Некорректное изменение матрицы!");
+		}
+		setDynamicElement(&a, row - 1, column - 1, value);
+		if (countOnly)
+		{
+			printSpecialElementCount(a.specialCount);
+		}
+		else
+		{
+			printMatrixChanges(&a);
+		}
+	}
+	if (reader.failed)
+	{
+		terminate("Некорректное изменение матрицы!");
+	}
+	closeIntegerReader(&reader);
+	fclose(input);
+	deleteDynamicMatrix(&a);
+}
+
+void reportSpecialElements(Matrix a, const Options* options)
+{
+	if (options->updatesFileName != NULL)
+	{
+		applyMatrixUpdates(a, options->updatesFileName, options->countOnly);
+		return;
+	}
+	if (options->countOnly)
+	{
+		printSpecialElementCount(countSpecialElements(a, options->threadCount));
+		return;
+	}
+	MatrixIndexArray answer = findFirstSpecialElements(a, options->threadCount,
+	                                                   options->limit);
+	printSpecialElements(answer);
+	
+	answer.size = 0;
+	free(answer.data);
+	answer.data = NULL;
+}
+
+bool parseElementType(const char* name, MatrixElementType* type)
+{
+	const char* names[] = {"int8", "int16", "int32", "float", "double"};
+	const MatrixElementType types[] = {MATRIX_ELEMENT_INT8,
+	                                   MATRIX_ELEMENT_INT16,
+	                                   MATRIX_ELEMENT_INT32,
+	                                   MATRIX_ELEMENT_FLOAT,
+	                                   MATRIX_ELEMENT_DOUBLE};
+	for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+	{
+		if (strcmp(name, names[i]) == 0)
+		{
+			*type = types[i];
+			return true;
+		}
+	}
+	return false;
+}
+
+void parseOptions(int argc, char* argv[], Options* options)
+{
+	bool typeGiven = false;
+	options->threadCount = 1;
+	options->textFileName = NULL;
+	options->streamFileName = NULL;
+	options->binaryFileName = NULL;
+	options->convertFileNames[0] = NULL;
+	options->convertFileNames[1] = NULL;
+	options->updatesFileName = NULL;
+	options->elementType = MATRIX_ELEMENT_INT32;
+	options->countOnly = false;
+	options->limit = SIZE_MAX;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+		{
+			/* Без сборки с -DMATRIX_THREADS части выполняются по очереди. */
+			options->threadCount = atoi(argv[++i]);
+			if (options->threadCount <= 0)
+			{
+				options->threadCount = getProcessorCount();
+			}
+		}
+		else if (strcmp(argv[i], "--count") == 0)
+		{
+			options->countOnly = true;
+		}
+		else if (strcmp(argv[i], "--first") == 0 && i + 1 < argc &&
+		         strtoull(argv[i + 1], NULL, 10) > 0)
+		{
+			options->limit = (size_t)strtoull(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--updates") == 0 && i + 1 < argc)
+		{
+			options->updatesFileName = argv[++i];
+		}
+		else if (strcmp(argv[i], "--type") == 0 && i + 1 < argc &&
+		         parseElementType(argv[i + 1], &options->elementType))
+		{
+			typeGiven = true;
+			i++;
+		}
+		else if (strcmp(argv[i], "--text") == 0 && i + 1 < argc)
+		{
+			options->textFileName = argv[++i];
+		}
+		else if (strcmp(argv[i], "--stream") == 0 && i + 1 < argc)
+		{
+			options->streamFileName = argv[++i];
+		}
+		else if (strcmp(argv[i], "--binary") == 0 && i + 1 < argc)
+		{
+			options->binaryFileName = argv[++i];
+		}
+		else if (strcmp(argv[i], "--convert") == 0 && i + 2 < argc)
+		{
+			options->convertFileNames[0] = argv[++i];
+			options->convertFileNames[1] = argv[++i];
+		}
+		else
+		{
+			terminate("Использование: программа [--threads N] [--count | "
+			          "--first K] [--updates ФАЙЛ] [--text ФАЙЛ | --stream "
+			          "ФАЙЛ | --binary ФАЙЛ | --convert ТЕКСТ ФАЙЛ [--type "
+			          "ТИП]]\n"
+			          "--threads N - загружать текст и искать в N потоках "
+			          "(0 - по числу процессоров); потоки есть только в "
+			          "сборке с -DMATRIX_THREADS (и -pthread), иначе части "
+			          "выполняются по очереди.\n"
+			          "--count - вывести только количество особых элементов.\n"
+			          "--first K - вывести только первые K особых элементов.\n"
+			          "--updates ФАЙЛ - затем применять изменения элементов "
+			          "\"i j v\" из файла и после каждого выводить элементы, "
+			          "ставшие (+) и переставшие быть (-) особыми.\n"
+			          "--text ФАЙЛ - загрузить матрицу из текстового файла "
+			          "(n, m и элементы матрицы по строкам).\n"
+			          "--stream ФАЙЛ - искать, не загружая матрицу в память "
+			          "(\"-\" - стандартный ввод); файл содержит n, m и "
+			          "элементы матрицы по строкам.\n"
+			          "--binary ФАЙЛ - искать в двоичном файле матрицы, "
+			          "отображенном в память.\n"
+			          "--convert ТЕКСТ ФАЙЛ - записать матрицу из текстового "
+			          "файла в двоичный.\n"
+			          "--type ТИП - тип элементов двоичного файла для "
+			          "--convert: int8, int16, int32 (по умолчанию), float "
+			          "или double.");
+		}
+	}
+	/*
+	 * Текстовые матрицы, стандартный ввод и изменения читаются только как
+	 * int, а тип двоичного файла записан в его заголовке.
+	 */
+	if (typeGiven && options->convertFileNames[0] == NULL)
+	{
+		terminate("Параметр --type используется только вместе с --convert: "
+		          "текст, стандартный ввод и изменения читаются как int, а "
+		          "тип двоичного файла берется из его заголовка!");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	setlocale(LC_ALL, "rus");
+	/* Вещественные числа в файлах матриц записываются с точкой. */
+	setlocale(LC_NUMERIC, "C");
+	
+	Options options;
+	parseOptions(argc, argv, &options);
+	
+	if (options.streamFileName != NULL)
+	{
+		FILE* input = (strcmp(options.streamFileName, "-") == 0)
+		              ? stdin : fopen(options.streamFileName, "r");
+		if (input == NULL)
+		{
+			terminate("Не удалось открыть файл матрицы!");
+		}
+		findSpecialElementsInStream(input, options.limit, options.countOnly);
+		if (input != stdin)
+		{
+			fclose(input);
+		}
+		return EXIT_SUCCESS;
+	}
+	if (options.convertFileNames[0] != NULL)
+	{
+		convertMatrixFile(options.convertFileNames[0],
+		                  options.convertFileNames[1], options.elementType);
+		return EXIT_SUCCESS;
+	}
+	if (options.textFileName != NULL)
+	{
+		Matrix a;
+		loadTextMatrix(options.textFileName, options.threadCount, &a);
+		reportSpecialElements(a, &options);
+		deleteMatrix(&a);
+		return EXIT_SUCCESS;
+	}
+	if (options.binaryFileName != NULL)
+	{
+		MappedMatrix file;
+		mapMatrixFile(options.binaryFileName, &file);
+		reportSpecialElements(file.matrix, &options);
+		unmapMatrixFile(&file);
+		return EXIT_SUCCESS;
+	}
+	
+	printf("Введите количество строк матрицы n: ");
+	int n, m;
+	if (!scanf("%d", &n) || n <= 0)
+	{
+		terminate("Введите корректное значние размера!");
+	}
+	
+	printf("Введите количество столбцов матрицы m: ");
+	if (!scanf("%d", &m) || m <= 0)
+	{
+		terminate("Введите корректное значние размера!");
+	}
+	
+	Matrix a;
+	createMatrix(&a, MATRIX_ELEMENT_INT32, n, m);
+	
+	puts("Введите матрицу размером n*m:");
+	if (isInteractiveInput())
+	{
+		for (int i = 0; i < n; i++)
+		{
+			int* row = getMatrixRow(a, i);
+			for (int j = 0; j < m; j++)
+			{
+				scanf("%d", &row[j]);
+			}
+		}
+	}
+	else
+	{
+		IntegerReader reader;
+		openIntegerReader(&reader, stdin, 0);
+		for (int i = 0; i < n; i++)
+		{
+			if (!readMatrixRow(&reader, getMatrixRow(a, i), m))
+			{
+				terminate("Матрица неполная или содержит некорректные значения!");
+			}
+		}
+		closeIntegerReader(&reader);
+	}
+	
+	reportSpecialElements(a, &options);
 	
 	deleteMatrix(&a);
 	
@@ -1,413 +1,6135 @@
+/*
+ * Сборка: gcc -std=c11 -O2 742.c -o 742 -lm (sqrt из libm нужен для
+ * статистики); с потоками: -DREGISTRY_THREADS -pthread.
+ */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <locale.h>
 #include <string.h>
+#include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef REGISTRY_THREADS
+#include <stdatomic.h>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+#endif
 
 #define STRING_BUFFER_MAX_SIZE (1 << 10)
+#define COLLATION_KEY_MAX_SIZE (4 * STRING_BUFFER_MAX_SIZE)
+
+#define READER_ERROR_REPORT_LIMIT 20
+
+#define ARCHIVE_SIGNATURE "NTZ2"
+#define ARCHIVE_HEADER_SIZE 32
+#define ARCHIVE_BLOCK_SIZE 256
+
+#define BENCHMARK_LOOKUP_COUNT 16
+
+#define NO_STUDENT ((size_t)-1)
+
+#define NOTES_ORDER_HEADER "#sorted"
+
+#define NOTES_INDEX_STRIDE 1024
+#define NOTES_PAGE_SIZE 10
+/*
+ * Если в конце упорядоченного файла накопилось больше добавленных
+ * записей, то при просмотре файл перезаписывается уже упорядоченным.
+ */
+#define NOTES_TAIL_REWRITE_THRESHOLD 1024
+
+/* Объем памяти в байтах под записи при удалении дубликатов в памяти. */
+#define DEDUPLICATION_MEMORY_LIMIT ((size_t)256 << 20)
+
+#define HISTORY_SIGNATURE "NTH1"
+#define HISTORY_SUFFIX ".history"
+#define HISTORY_CHECKPOINT_INTERVAL 16
+
+#define GRADE_MAX 10
+#define GPA_HISTOGRAM_BINS 1000
+#define STATISTICS_CHUNK_SIZE (1 << 12)
+
+#define EXPORT_PARALLEL_MIN_SIZE (1 << 16)
+
+#define SHARD_TOP_MAX_SIZE 1000
+
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+#define OUTPUT_BUFFER_MIN_SIZE (6 * STRING_BUFFER_MAX_SIZE + 2)
+#define READER_BUFFER_SIZE (1 << 16)
+
+#define PROFILE_SUB_BUCKET_BITS 4
+#define PROFILE_SUB_BUCKETS (1 << PROFILE_SUB_BUCKET_BITS)
+#define PROFILE_BUCKET_COUNT (PROFILE_SUB_BUCKETS * (65 - PROFILE_SUB_BUCKET_BITS))
+
+#ifdef REGISTRY_PROFILE
+#define PROFILE_BEGIN(operation) \
+	uint64_t operation##Start = getMonotonicNanoseconds()
+#define PROFILE_END(operation, items) \
+	recordProfileSample(operation, \
+	                    getMonotonicNanoseconds() - operation##Start, items)
+#else
+#define PROFILE_BEGIN(operation) ((void)0)
+#define PROFILE_END(operation, items) ((void)(items))
+#endif
+
+/*
+ * Единственное описание полей записи о студенте: имя поля, тип, подпись
+ * при просмотре и запросы при добавлении и изменении записи. Из этого
+ * списка строятся структура, чтение, запись, сравнение, копирование,
+ * архивирование и поколоночное представление записей.
+ */
+#define STUDENT_FIELDS(FIELD) \
+	FIELD(surname, STRING, "Фамилия", \
+	      "Введите фамилию студента:", \
+	      "Введите новую фамилию студента:") \
+	FIELD(group, INT, "Номер группы", \
+	      "Введите номер группы студента:", \
+	      "Введите новый номер группы студента:") \
+	FIELD(physicsGrade, INT, "Оценка за семестр по физике", \
+	      "Введите оценку за семестр студента по физике:", \
+	      "Введите новую оценку за семестр по физике студента:") \
+	FIELD(mathsGrade, INT, "Оценка за семестр по математике", \
+	      "Введите оценку за семестр студента по математике:", \
+	      "Введите новую оценку за семестр по математике студента:") \
+	FIELD(informaticsGrade, INT, "Оценка за семестр по информатике", \
+	      "Введите оценку за семестр студента по информатике:", \
+	      "Введите новую оценку за семестр по информатике студента:") \
+	FIELD(GPA, REAL, "Средний балл студента", \
+	      "Введите средний балл студента:", \
+	      "Введите новый средний балл студента:")
+
+/*
+ * Допустимые значения числовых полей. Записи со значениями вне диапазона
+ * отклоняются при чтении файла, а при вводе значение запрашивается снова.
+ */
+#define STUDENT_FIELD_LIMITS(LIMIT) \
+	LIMIT(group, 0, INT_MAX) \
+	LIMIT(physicsGrade, 0, GRADE_MAX) \
+	LIMIT(mathsGrade, 0, GRADE_MAX) \
+	LIMIT(informaticsGrade, 0, GRADE_MAX) \
+	LIMIT(GPA, 0, GRADE_MAX)
+
+/*
+ * Величины, по которым считается статистика: сначала оценки (для них
+ * строятся гистограммы), затем средний балл.
+ */
+#define STATISTICS_GRADES(VARIABLE) \
+	VARIABLE(physicsGrade, "Физика") \
+	VARIABLE(mathsGrade, "Математика") \
+	VARIABLE(informaticsGrade, "Информатика")
+
+/*
+ * Критерии сортировки: номер в меню, поле, направление, отношение, которое
+ * должно выполняться для соседних записей, и название в меню. Строковые и
+ * числовые критерии перечислены отдельно: по строковым полям сортируются
+ * ключи сопоставления, а по числовым - сгенерированные сортировки.
+ */
+#define STUDENT_SORT_CRITERIA(CRITERION) \
+	STUDENT_STRING_SORT_CRITERIA(CRITERION) \
+	STUDENT_NUMERIC_SORT_CRITERIA(CRITERION)
+
+#define STUDENT_STRING_SORT_CRITERIA(CRITERION) \
+	CRITERION(1, surname, Ascending, <, "По алфавиту (фамилия)")
+
+#define STUDENT_NUMERIC_SORT_CRITERIA(CRITERION) \
+	CRITERION(2, physicsGrade, Ascending, <, \
+	          "По возрастанию оценки по физике") \
+	CRITERION(3, physicsGrade, Descending, >, \
+	          "По убыванию оценки по физике") \
+	CRITERION(4, mathsGrade, Ascending, <, \
+	          "По возрастанию оценки по математике") \
+	CRITERION(5, mathsGrade, Descending, >, \
+	          "По убыванию оценки по математике") \
+	CRITERION(6, informaticsGrade, Ascending, <, \
+	          "По возрастанию оценки по информатике") \
+	CRITERION(7, informaticsGrade, Descending, >, \
+	          "По убыванию оценки по информатике") \
+	CRITERION(8, GPA, Ascending, <, "По возрастанию среднего балла") \
+	CRITERION(9, GPA, Descending, >, "По убыванию среднего балла")
+
+#define DECLARE_FIELD_STRING(name) char name[STRING_BUFFER_MAX_SIZE]
+#define DECLARE_FIELD_INT(name) int name
+#define DECLARE_FIELD_REAL(name) double name
+
+#define DECLARE_COLUMN_STRING(name) const char **name
+#define DECLARE_COLUMN_INT(name) int *name
+#define DECLARE_COLUMN_REAL(name) double *name
+
+#define PARSE_FIELD_STRING(field, text, index) parseStringField(field, text)
+#define PARSE_FIELD_INT(field, text, index) \
+	parseIntField(&(field), text, STUDENT_FIELD_RANGES[index])
+#define PARSE_FIELD_REAL(field, text, index) \
+	parseRealField(&(field), text, STUDENT_FIELD_RANGES[index])
+
+#define OUTPUT_FIELD_STRING(output, field) outputString(output, field)
+#define OUTPUT_FIELD_INT(output, field) outputInt(output, field)
+#define OUTPUT_FIELD_REAL(output, field) outputFixed(output, field)
+
+#define COPY_FIELD_STRING(destination, source) strcpy(destination, source)
+#define COPY_FIELD_INT(destination, source) destination = source
+#define COPY_FIELD_REAL(destination, source) destination = source
+
+#define COMPARE_FIELD_STRING(a, b) compareCollated(a, b)
+#define COMPARE_FIELD_INT(a, b) (((a) > (b)) - ((a) < (b)))
+#define COMPARE_FIELD_REAL(a, b) (((a) > (b)) - ((a) < (b)))
+
+#define DECLARE_STUDENT_FIELD(name, type, ...) DECLARE_FIELD_##type(name);
+#define DECLARE_STUDENT_COLUMN(name, type, ...) DECLARE_COLUMN_##type(name);
+#define ENUMERATE_STUDENT_FIELD(name, ...) STUDENT_FIELD_##name,
+#define DESCRIBE_STUDENT_FIELD(name, type, ...) \
+	{ FIELD_TYPE_##type, offsetof(Student, name) },
+#define LIST_STUDENT_FIELD_TITLE(name, type, title, ...) title,
+#define LIST_STUDENT_FIELD_PROMPT(name, type, title, prompt, ...) prompt,
+#define DESCRIBE_STUDENT_FIELD_RANGE(name, minimum, maximum) \
+	[STUDENT_FIELD_##name] = { minimum, maximum },
+#define COUNT_SORT_CRITERION(...) + 1
+#define LIST_SORT_CRITERION_TITLE(number, field, order, relation, title) \
+	title,
+#define LIST_SORT_CRITERION_FIELD(number, field, ...) STUDENT_FIELD_##field,
+#define LIST_SORT_CRITERION_SIGN(number, field, order, relation, title) \
+	(0 relation 1) ? 1 : -1,
+
+#define STUDENT_FIELD_AT(student, field, type) \
+	((type *)((char *)(student) + STUDENT_FIELD_DESCRIPTORS[field].offset))
+#define CONST_STUDENT_FIELD_AT(student, field, type) \
+	((const type *)((const char *)(student) + \
+	                STUDENT_FIELD_DESCRIPTORS[field].offset))
 
 typedef struct Student
 {
-	char surname[STRING_BUFFER_MAX_SIZE];
-	int group;
-	int physicsGrade;
-	int mathsGrade;
-	int informaticsGrade;
-	double GPA;
+	STUDENT_FIELDS(DECLARE_STUDENT_FIELD)
 } Student;
 
+typedef enum
+{
+	STUDENT_FIELDS(ENUMERATE_STUDENT_FIELD)
+	STUDENT_FIELD_COUNT
+} StudentField;
+
+enum
+{
+	STUDENT_SORT_CRITERION_COUNT = 0 STUDENT_SORT_CRITERIA(COUNT_SORT_CRITERION)
+};
+
+typedef enum
+{
+	FIELD_TYPE_STRING,
+	FIELD_TYPE_INT,
+	FIELD_TYPE_REAL
+} FieldType;
+
+typedef struct
+{
+	FieldType type;
+	size_t offset;
+} StudentFieldDescriptor;
+
+const StudentFieldDescriptor STUDENT_FIELD_DESCRIPTORS[STUDENT_FIELD_COUNT] = {
+	STUDENT_FIELDS(DESCRIBE_STUDENT_FIELD)
+};
+
+typedef struct
+{
+	double minimum;
+	double maximum;
+} StudentFieldRange;
+
+const StudentFieldRange STUDENT_FIELD_RANGES[STUDENT_FIELD_COUNT] = {
+	STUDENT_FIELD_LIMITS(DESCRIBE_STUDENT_FIELD_RANGE)
+};
+
+const char *const STUDENT_FIELD_TITLES[STUDENT_FIELD_COUNT] = {
+	STUDENT_FIELDS(LIST_STUDENT_FIELD_TITLE)
+};
+
+const char *const STUDENT_FIELD_PROMPTS[STUDENT_FIELD_COUNT] = {
+	STUDENT_FIELDS(LIST_STUDENT_FIELD_PROMPT)
+};
+
+const char *const STUDENT_SORT_CRITERION_TITLES[] = {
+	STUDENT_SORT_CRITERIA(LIST_SORT_CRITERION_TITLE)
+};
+
+const StudentField STUDENT_SORT_CRITERION_FIELDS[] = {
+	STUDENT_SORT_CRITERIA(LIST_SORT_CRITERION_FIELD)
+};
+
+const int STUDENT_SORT_CRITERION_SIGNS[] = {
+	STUDENT_SORT_CRITERIA(LIST_SORT_CRITERION_SIGN)
+};
+
 typedef struct
 {
 	Student *data;
 	size_t size;
 } StudentArray;
 
-void addStudent(StudentArray *students, Student s)
+typedef struct
+{
+	size_t size;
+	STUDENT_FIELDS(DECLARE_STUDENT_COLUMN)
+} StudentColumns;
+
+typedef struct
+{
+	const unsigned char *key;
+	size_t length;
+	size_t index;
+} CollationKey;
+
+typedef struct
+{
+	FILE *stream;
+	char *buffer;
+	size_t size;
+	size_t position;
+	uint64_t bufferOffset;
+	size_t lineNumber;
+	bool linesCounted;
+	bool truncated;
+	bool quiet;
+	size_t errorCount;
+} StudentReader;
+
+typedef struct
+{
+	int criterion;
+	size_t sortedCount;
+} NotesOrder;
+
+typedef struct
+{
+	uint64_t *offsets;
+	size_t count;
+	size_t studentCount;
+} NotesIndex;
+
+typedef struct
+{
+	size_t first;
+	size_t pending;
+} StudentKeySlot;
+
+typedef struct
+{
+	StudentKeySlot *slots;
+	size_t capacity;
+	size_t *next;
+} StudentKeyTable;
+
+typedef enum
+{
+	MERGE_KEEP_MASTER = 1,
+	MERGE_TAKE_UPDATE,
+	MERGE_TAKE_MAXIMUM
+} MergePolicy;
+
+typedef enum
+{
+	DEDUPLICATE_LATEST = 1,
+	DEDUPLICATE_HIGHEST_GPA,
+	DEDUPLICATE_MAXIMUM
+} DeduplicationPolicy;
+
+typedef struct
+{
+	size_t added;
+	size_t removed;
+	size_t changed;
+	size_t unchanged;
+} NotesDiffSummary;
+
+typedef enum
+{
+	HISTORY_CHECKPOINT = 'C',
+	HISTORY_DELTA = 'D'
+} HistoryEntryKind;
+
+typedef enum
+{
+	HISTORY_OPERATION_SAME,
+	HISTORY_OPERATION_MOVE,
+	HISTORY_OPERATION_NEW
+} HistoryOperation;
+
+typedef struct
+{
+	HistoryEntryKind kind;
+	uint64_t version;
+	uint64_t time;
+	uint64_t checksum;
+	uint64_t studentCount;
+	char description[STRING_BUFFER_MAX_SIZE];
+	uint64_t payloadOffset;
+	uint64_t payloadLength;
+} HistoryEntry;
+
+typedef struct
+{
+	size_t *slots;
+	size_t capacity;
+} StudentContentTable;
+
+typedef struct
+{
+	unsigned char *data;
+	size_t size;
+	size_t capacity;
+} ByteBuffer;
+
+typedef struct
+{
+	const unsigned char *data;
+	size_t size;
+	size_t position;
+	bool failed;
+} ByteReader;
+
+typedef struct
+{
+	uint32_t blockSize;
+	uint64_t studentCount;
+	uint64_t blockCount;
+	uint64_t indexOffset;
+} ArchiveHeader;
+
+typedef struct
+{
+	FILE *stream;
+	char *data;
+	size_t size;
+	size_t capacity;
+	char decimalPoint;
+	char reserve[OUTPUT_BUFFER_MIN_SIZE];
+} OutputBuffer;
+
+typedef enum
+{
+	EXPORT_JSON = 1,
+	EXPORT_CSV
+} ExportFormat;
+
+typedef struct
+{
+	const char *fileName;
+	const NotesIndex *index;
+	ExportFormat format;
+	size_t partCount;
+	FILE **parts;
+	size_t *counts;
+	bool *failures;
+} ExportJob;
+
+typedef void (*ParallelTask)(void *context, size_t index);
+
+#ifdef REGISTRY_THREADS
+typedef struct
+{
+	ParallelTask task;
+	void *context;
+	size_t index;
+} ParallelJob;
+#endif
+
+typedef struct
+{
+	ParallelTask task;
+	void *context;
+	size_t itemCount;
+#ifdef REGISTRY_THREADS
+	atomic_size_t next;
+#else
+	size_t next;
+#endif
+} WorkQueue;
+
+#define ENUMERATE_STATISTICS_GRADE(name, title) STATISTICS_##name,
+
+enum
+{
+	STATISTICS_GRADES(ENUMERATE_STATISTICS_GRADE)
+	STATISTICS_GRADE_COUNT,
+	STATISTICS_GPA = STATISTICS_GRADE_COUNT,
+	STATISTICS_VARIABLE_COUNT
+};
+
+/*
+ * Частичная статистика по части записей: количество, средние,
+ * совместные центральные моменты (сумма произведений отклонений от
+ * средних) и гистограммы. Частичные статистики разных потоков
+ * объединяются без повторного прохода по записям.
+ */
+typedef struct
+{
+	size_t count;
+	double mean[STATISTICS_VARIABLE_COUNT];
+	double comoment[STATISTICS_VARIABLE_COUNT][STATISTICS_VARIABLE_COUNT];
+	size_t gradeHistogram[STATISTICS_GRADE_COUNT][GRADE_MAX + 2];
+	size_t gpaHistogram[GPA_HISTOGRAM_BINS + 1];
+	double gpaMin;
+	double gpaMax;
+} StudentStatistics;
+
+typedef struct
+{
+	const StudentColumns *columns;
+	StudentStatistics *partials;
+	double *values;
+	size_t threadCount;
+	size_t partCount;
+} StatisticsJob;
+
+typedef struct
+{
+	char **files;
+	size_t count;
+} ShardManifest;
+
+typedef enum
+{
+	SHARD_QUERY_SEARCH = 1,
+	SHARD_QUERY_FILTER,
+	SHARD_QUERY_TOP,
+	SHARD_QUERY_STATISTICS
+} ShardQueryKind;
+
+typedef struct
+{
+	ShardQueryKind kind;
+	char surname[STRING_BUFFER_MAX_SIZE];
+	int field;
+	double minimum;
+	double maximum;
+	int criterion;
+	size_t limit;
+} ShardQuery;
+
+/*
+ * Результат запроса по одному файлу: найденные записи (поиск и лучшие K
+ * записей), временный файл с отобранными записями (отбор) или частичная
+ * статистика со списком средних баллов (статистика).
+ */
+typedef struct
+{
+	bool opened;
+	size_t scanned;
+	StudentArray students;
+	FILE *part;
+	size_t matched;
+	StudentStatistics statistics;
+	double *gpa;
+} ShardResult;
+
+typedef struct
+{
+	const ShardManifest *manifest;
+	const ShardQuery *query;
+	ShardResult *results;
+} ShardJob;
+
+uint64_t getMonotonicNanoseconds(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (uint64_t)((double)counter.QuadPart * 1e9 /
+	                  (double)frequency.QuadPart);
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+#endif
+}
+
+double getMonotonicTime(void)
+{
+	return (double)getMonotonicNanoseconds() / 1e9;
+}
+
+size_t getThreadCount(void)
+{
+#if !defined(REGISTRY_THREADS)
+	return 1;
+#elif defined(_WIN32)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (info.dwNumberOfProcessors > 0) ? info.dwNumberOfProcessors : 1;
+#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return (count > 0) ? (size_t)count : 1;
+#endif
+}
+
+#ifdef REGISTRY_THREADS
+#ifdef _WIN32
+DWORD WINAPI runParallelJob(LPVOID argument)
+#else
+void *runParallelJob(void *argument)
+#endif
 {
-	if (students->size == 0)
+	ParallelJob *job = (ParallelJob *)argument;
+	job->task(job->context, job->index);
+	return 0;
+}
+#endif
+
+/*
+ * Выполняет task(context, i) для i от 0 до count - 1. При сборке с
+ * REGISTRY_THREADS каждая часть выполняется в своем потоке, иначе части
+ * выполняются по очереди.
+ */
+void runParallel(ParallelTask task, void *context, size_t count)
+{
+#ifdef REGISTRY_THREADS
+	ParallelJob *jobs = (ParallelJob *)malloc(count * sizeof(ParallelJob));
+#ifdef _WIN32
+	HANDLE *threads = (HANDLE *)malloc(count * sizeof(HANDLE));
+#else
+	pthread_t *threads = (pthread_t *)malloc(count * sizeof(pthread_t));
+	bool *started = (bool *)malloc(count * sizeof(bool));
+#endif
+	for (size_t i = 0; i < count; i++)
 	{
-		students->data = (Student *)malloc(++students->size * sizeof(Student));
+		jobs[i].task = task;
+		jobs[i].context = context;
+		jobs[i].index = i;
+#ifdef _WIN32
+		threads[i] = CreateThread(NULL, 0, runParallelJob, &jobs[i], 0, NULL);
+		if (threads[i] == NULL)
+#else
+		started[i] = pthread_create(&threads[i], NULL, runParallelJob,
+		                            &jobs[i]) == 0;
+		if (!started[i])
+#endif
+		{
+			task(context, i);
+		}
 	}
-	else
+	for (size_t i = 0; i < count; i++)
 	{
-		students->data = (Student *)realloc(students->data,
-		                                    ++students->size * sizeof(Student));
+#ifdef _WIN32
+		if (threads[i] != NULL)
+		{
+			WaitForSingleObject(threads[i], INFINITE);
+			CloseHandle(threads[i]);
+		}
+#else
+		if (started[i])
+		{
+			pthread_join(threads[i], NULL);
+		}
+#endif
+	}
+#ifndef _WIN32
+	free(started);
+#endif
+	free(threads);
+	free(jobs);
+#else
+	for (size_t i = 0; i < count; i++)
+	{
+		task(context, i);
 	}
-	strcpy(students->data[students->size - 1].surname, s.surname);
-	students->data[students->size - 1].group = s.group;
-	students->data[students->size - 1].physicsGrade = s.physicsGrade;
-	students->data[students->size - 1].mathsGrade = s.mathsGrade;
-	students->data[students->size - 1].informaticsGrade = s.informaticsGrade;
-	students->data[students->size - 1].GPA = s.GPA;
+#endif
 }
 
-void removeLastStudent(StudentArray *students)
+void workOnQueue(void *context, size_t worker)
 {
-	if (students->size != 0)
+	(void)worker;
+	WorkQueue *queue = (WorkQueue *)context;
+	while (true)
 	{
-		students->data = (Student *)realloc(students->data,
-		                                    --students->size * sizeof(Student));
+#ifdef REGISTRY_THREADS
+		size_t item = atomic_fetch_add(&queue->next, 1);
+#else
+		size_t item = queue->next++;
+#endif
+		if (item >= queue->itemCount)
+		{
+			return;
+		}
+		queue->task(queue->context, item);
 	}
 }
 
-StudentArray getStudents(FILE *notes)
+/*
+ * Пул потоков для заданий разного размера: потоков не больше, чем
+ * процессоров, и каждый освободившийся поток берет следующее задание.
+ */
+void runWorkQueue(ParallelTask task, void *context, size_t itemCount)
 {
-	StudentArray students;
-	students.size = 0;
-	students.data = NULL;
-	
-	Student currentStudent;
-	currentStudent.group = 0;
-	currentStudent.physicsGrade = 0;
-	currentStudent.mathsGrade = 0;
-	currentStudent.informaticsGrade = 0;
-	currentStudent.GPA = .0f;
-	
-	char current;
-	int currentNote = 1;
-	char currentStr[STRING_BUFFER_MAX_SIZE];
-	size_t currentStrIndex = 0;
-	while ((current = (char)fgetc(notes)) != EOF)
+	WorkQueue queue;
+	queue.task = task;
+	queue.context = context;
+	queue.itemCount = itemCount;
+#ifdef REGISTRY_THREADS
+	atomic_init(&queue.next, 0);
+#else
+	queue.next = 0;
+#endif
+	size_t workerCount = getThreadCount();
+	if (workerCount > itemCount)
+	{
+		workerCount = itemCount;
+	}
+	runParallel(workOnQueue, &queue, workerCount);
+}
+
+#ifdef REGISTRY_PROFILE
+typedef enum
+{
+	PROFILE_GET_STUDENTS,
+	PROFILE_WRITE_STUDENTS,
+	PROFILE_SWAP_STUDENTS,
+	PROFILE_SORT_STUDENTS,
+	PROFILE_INDIVIDUAL_TASK,
+	PROFILE_FIND_STUDENT,
+	PROFILE_OPERATION_COUNT
+} ProfileOperation;
+
+typedef struct
+{
+	uint64_t count;
+	uint64_t totalNanoseconds;
+	uint64_t items;
+	uint64_t buckets[PROFILE_BUCKET_COUNT];
+} ProfileStatistics;
+
+const char *const PROFILE_OPERATION_NAMES[PROFILE_OPERATION_COUNT] = {
+	"getStudents", "writeStudentsToFile", "swapStudents", "sortStudents",
+	"individualTask", "findStudent"
+};
+
+ProfileStatistics profileStatistics[PROFILE_OPERATION_COUNT];
+
+/*
+ * Гистограмма длительностей: по 16 корзин на каждую степень двойки,
+ * поэтому процентили вычисляются с погрешностью не более 1/16 без
+ * хранения всех замеров.
+ */
+size_t getProfileBucket(uint64_t nanoseconds)
+{
+	if (nanoseconds < PROFILE_SUB_BUCKETS)
 	{
-		if (current == '\n')
+		return (size_t)nanoseconds;
+	}
+	int exponent = 63;
+	while ((nanoseconds >> exponent) == 0)
+	{
+		exponent--;
+	}
+	int shift = exponent - PROFILE_SUB_BUCKET_BITS;
+	return (size_t)(shift + 1) * PROFILE_SUB_BUCKETS +
+	       (size_t)((nanoseconds >> shift) & (PROFILE_SUB_BUCKETS - 1));
+}
+
+uint64_t getProfileBucketValue(size_t bucket)
+{
+	if (bucket < PROFILE_SUB_BUCKETS)
+	{
+		return bucket;
+	}
+	int shift = (int)(bucket / PROFILE_SUB_BUCKETS) - 1;
+	uint64_t subBucket = PROFILE_SUB_BUCKETS + bucket % PROFILE_SUB_BUCKETS;
+	return (subBucket << shift) + ((1ULL << shift) >> 1);
+}
+
+void recordProfileSample(ProfileOperation operation, uint64_t nanoseconds,
+                         uint64_t items)
+{
+	ProfileStatistics *statistics = &profileStatistics[operation];
+	statistics->count++;
+	statistics->totalNanoseconds += nanoseconds;
+	statistics->items += items;
+	statistics->buckets[getProfileBucket(nanoseconds)]++;
+}
+
+double getProfilePercentile(const ProfileStatistics *statistics,
+                            double percentile)
+{
+	uint64_t rank = (uint64_t)(percentile * (double)statistics->count);
+	if (rank >= statistics->count)
+	{
+		rank = statistics->count - 1;
+	}
+	uint64_t seen = 0;
+	for (size_t i = 0; i < PROFILE_BUCKET_COUNT; i++)
+	{
+		seen += statistics->buckets[i];
+		if (seen > rank)
 		{
-			currentStr[currentStrIndex] = '\0';
-			currentStrIndex = 0;
-			
-			switch (currentNote)
-			{
-				case 1:
-					strcpy(currentStudent.surname, currentStr);
-					break;
-				case 2:
-					currentStudent.group = atoi(currentStr);
-					break;
-				case 3:
-					currentStudent.physicsGrade = atoi(currentStr);
-					break;
-				case 4:
-					currentStudent.mathsGrade = atoi(currentStr);
-					break;
-				case 5:
-					currentStudent.informaticsGrade = atoi(currentStr);
-					break;
-				case 6:
-					currentStudent.GPA = atof(currentStr);
-					break;
-				default:
-					addStudent(&students, currentStudent);
-					
-					currentNote = 0;
-					break;
-			}
-			currentNote++;
+			return (double)getProfileBucketValue(i) / 1e9;
 		}
-		else
+	}
+	return 0;
+}
+
+void printProfileReport(void)
+{
+	fputs("Операция               Вызовов      Всего, с     p50, с     "
+	      "p99, с   Элементов\n", stderr);
+	for (int i = 0; i < PROFILE_OPERATION_COUNT; i++)
+	{
+		const ProfileStatistics *statistics = &profileStatistics[i];
+		if (statistics->count != 0)
 		{
-			currentStr[currentStrIndex++] = current;
+			fprintf(stderr, "%-20s %9" PRIu64 " %13.6lf %10.3e %10.3e %11"
+			        PRIu64 "\n", PROFILE_OPERATION_NAMES[i],
+			        statistics->count,
+			        (double)statistics->totalNanoseconds / 1e9,
+			        getProfilePercentile(statistics, 0.5),
+			        getProfilePercentile(statistics, 0.99),
+			        statistics->items);
 		}
 	}
 	
-	return students;
+	const char *jsonName = getenv("REGISTRY_PROFILE_JSON");
+	FILE *json = (jsonName != NULL) ? fopen(jsonName, "w") : NULL;
+	if (json == NULL)
+	{
+		return;
+	}
+	fputs("[", json);
+	bool first = true;
+	for (int i = 0; i < PROFILE_OPERATION_COUNT; i++)
+	{
+		const ProfileStatistics *statistics = &profileStatistics[i];
+		if (statistics->count != 0)
+		{
+			fprintf(json, "%s\n{\"operation\":\"%s\",\"count\":%" PRIu64
+			        ",\"totalSeconds\":%.9lf,\"p50Seconds\":%.9lf,"
+			        "\"p99Seconds\":%.9lf,\"items\":%" PRIu64 "}",
+			        first ? "" : ",", PROFILE_OPERATION_NAMES[i],
+			        statistics->count,
+			        (double)statistics->totalNanoseconds / 1e9,
+			        getProfilePercentile(statistics, 0.5),
+			        getProfilePercentile(statistics, 0.99),
+			        statistics->items);
+			first = false;
+		}
+	}
+	fputs("\n]\n", json);
+	fclose(json);
 }
+#endif
 
-void writeStudentsToFile(FILE *notes, StudentArray students)
+#define COPY_STUDENT_FIELD(name, type, ...) \
+	COPY_FIELD_##type(destination->name, source->name);
+
+void copyStudent(Student *destination, const Student *source)
 {
-	for (size_t i = 0; i < students.size; i++)
+	STUDENT_FIELDS(COPY_STUDENT_FIELD)
+}
+
+size_t getUtf8SequenceLength(const unsigned char *s)
+{
+	size_t length = (s[0] >= 0xF0) ? 4 : (s[0] >= 0xE0) ? 3 : 2;
+	if (s[0] < 0xC2 || s[0] > 0xF4)
+	{
+		return 0;
+	}
+	for (size_t i = 1; i < length; i++)
+	{
+		if ((s[i] & 0xC0) != 0x80)
+		{
+			return 0;
+		}
+	}
+	if ((s[0] == 0xE0 && s[1] < 0xA0) || (s[0] == 0xED && s[1] >= 0xA0) ||
+	    (s[0] == 0xF0 && s[1] < 0x90) || (s[0] == 0xF4 && s[1] >= 0x90))
 	{
-		fprintf(notes, "%s\n%d\n%d\n%d\n%d\n%lf\n\n",
-		        students.data[i].surname, students.data[i].group,
-		        students.data[i].physicsGrade, students.data[i].mathsGrade,
-		        students.data[i].informaticsGrade, students.data[i].GPA);
+		return 0;
 	}
+	return length;
 }
 
-void readFile(FILE *file)
+/*
+ * Некорректный байт UTF-8 превращается в отдельный символ из области
+ * U+DC80-U+DCFF, чтобы такие строки все равно упорядочивались.
+ */
+uint32_t decodeCollationCodePoint(const unsigned char **s)
 {
-	char current;
-	while ((current = (char)fgetc(file)) != EOF)
+	const unsigned char *c = *s;
+	if (c[0] < 0x80)
+	{
+		*s += (c[0] != '\0') ? 1 : 0;
+		return c[0];
+	}
+	size_t length = getUtf8SequenceLength(c);
+	if (length == 0)
+	{
+		(*s)++;
+		return 0xDC00 + c[0];
+	}
+	uint32_t codePoint = c[0] & (0x7F >> length);
+	for (size_t i = 1; i < length; i++)
+	{
+		codePoint = (codePoint << 6) | (c[i] & 0x3F);
+	}
+	*s += length;
+	return codePoint;
+}
+
+uint32_t toCollationLowercase(uint32_t c)
+{
+	if (('A' <= c && c <= 'Z') || (0x410 <= c && c <= 0x42F))
+	{
+		return c + 0x20;
+	}
+	if (0x400 <= c && c <= 0x40F)
+	{
+		return c + 0x50;
+	}
+	return (c == 0x490) ? 0x491 : c;
+}
+
+bool isCollationUppercase(uint32_t c)
+{
+	return toCollationLowercase(c) != c;
+}
+
+/*
+ * Первичный вес символа: знаки препинания и пробелы, затем цифры,
+ * латинские буквы и кириллица; регистр не учитывается. Кириллица идет в
+ * порядке русского алфавита (ё сразу после е), буквы украинского и
+ * белорусского алфавитов стоят на своих местах: ґ после г, є после ё,
+ * і и ї после и, ў после у. Остальные символы - по номеру после букв.
+ */
+uint32_t getCollationWeight(uint32_t c)
+{
+	c = toCollationLowercase(c);
+	if ('0' <= c && c <= '9')
+	{
+		return 0x100 + (c - '0');
+	}
+	if ('a' <= c && c <= 'z')
+	{
+		return 0x200 + (c - 'a');
+	}
+	if (0x430 <= c && c <= 0x44F)
+	{
+		return 0x300 + 4 * (c - 0x430);
+	}
+	switch (c)
+	{
+		case 0x491: // ґ
+			return 0x300 + 4 * (0x433 - 0x430) + 1;
+		case 0x451: // ё
+			return 0x300 + 4 * (0x435 - 0x430) + 1;
+		case 0x454: // є
+			return 0x300 + 4 * (0x435 - 0x430) + 2;
+		case 0x456: // і
+			return 0x300 + 4 * (0x438 - 0x430) + 1;
+		case 0x457: // ї
+			return 0x300 + 4 * (0x438 - 0x430) + 2;
+		case 0x45E: // ў
+			return 0x300 + 4 * (0x443 - 0x430) + 1;
+	}
+	if (c < 0x80)
+	{
+		return 1 + c;
+	}
+	return (c < 0xEFFF) ? 0x1000 + c : 0xFFFF;
+}
+
+/*
+ * Ключ сопоставления строки: первичные веса символов по два байта, два
+ * нулевых байта, регистр символов по байту (строчные раньше заглавных) и
+ * сами байты строки, поэтому сравнение ключей memcmp дает тот же порядок,
+ * что и compareCollated, а равны только ключи одинаковых строк. Длина
+ * ключа не больше 4 * strlen(s) + 2.
+ */
+size_t getCollationKey(const char *s, unsigned char *key)
+{
+	size_t length = 0;
+	const unsigned char *c = (const unsigned char *)s;
+	while (*c != '\0')
+	{
+		uint32_t weight = getCollationWeight(decodeCollationCodePoint(&c));
+		key[length++] = (unsigned char)(weight >> 8);
+		key[length++] = (unsigned char)weight;
+	}
+	key[length++] = 0;
+	key[length++] = 0;
+	c = (const unsigned char *)s;
+	while (*c != '\0')
+	{
+		key[length++] = isCollationUppercase(decodeCollationCodePoint(&c))
+		                ? 2 : 1;
+	}
+	size_t size = strlen(s);
+	memcpy(key + length, s, size);
+	return length + size;
+}
+
+/*
+ * Сравнение двух строк без построения ключей: для одиночных сравнений
+ * (проверка порядка, вставка в упорядоченный список) это дешевле, чем
+ * строить ключи, и обычно заканчивается на первом различном символе.
+ */
+int compareCollated(const char *s1, const char *s2)
+{
+	const unsigned char *c1 = (const unsigned char *)s1;
+	const unsigned char *c2 = (const unsigned char *)s2;
+	while (*c1 != '\0' && *c2 != '\0')
+	{
+		uint32_t w1 = getCollationWeight(decodeCollationCodePoint(&c1));
+		uint32_t w2 = getCollationWeight(decodeCollationCodePoint(&c2));
+		if (w1 != w2)
+		{
+			return (w1 > w2) - (w1 < w2);
+		}
+	}
+	if (*c1 != '\0' || *c2 != '\0')
+	{
+		return (*c1 != '\0') - (*c2 != '\0');
+	}
+	c1 = (const unsigned char *)s1;
+	c2 = (const unsigned char *)s2;
+	while (*c1 != '\0')
+	{
+		bool u1 = isCollationUppercase(decodeCollationCodePoint(&c1));
+		bool u2 = isCollationUppercase(decodeCollationCodePoint(&c2));
+		if (u1 != u2)
+		{
+			return u1 ? 1 : -1;
+		}
+	}
+	int order = strcmp(s1, s2);
+	return (order > 0) - (order < 0);
+}
+
+#define DEFINE_STUDENT_COMPARATOR(name, type, ...) \
+int compareStudentsBy_##name(const Student *s1, const Student *s2) \
+{ \
+	return COMPARE_FIELD_##type(s1->name, s2->name); \
+}
+
+STUDENT_FIELDS(DEFINE_STUDENT_COMPARATOR)
+
+/*
+ * Емкость массива (capacity) удваивается, поэтому добавление n записей
+ * стоит O(n) копирований. Если число записей не помещается в память,
+ * возвращается false, а массив не меняется.
+ */
+bool addStudent(StudentArray *students, size_t *capacity,
+                const Student *student)
+{
+	if (students->size == *capacity)
+	{
+		if (*capacity > SIZE_MAX / 2 / sizeof(Student))
+		{
+			return false;
+		}
+		size_t newCapacity = (*capacity == 0) ? 16 : 2 * *capacity;
+		Student *data = (Student *)realloc(students->data,
+		                                   newCapacity * sizeof(Student));
+		if (data == NULL)
+		{
+			return false;
+		}
+		students->data = data;
+		*capacity = newCapacity;
+	}
+	copyStudent(&students->data[students->size++], student);
+	return true;
+}
+
+void removeLastStudent(StudentArray *students)
+{
+	if (students->size != 0)
+	{
+		students->data = (Student *)realloc(students->data,
+		                                    --students->size * sizeof(Student));
+	}
+}
+
+void openStudentReader(StudentReader *reader, FILE *stream)
+{
+	reader->stream = stream;
+	reader->buffer = (char *)malloc(READER_BUFFER_SIZE);
+	reader->size = 0;
+	reader->position = 0;
+	reader->bufferOffset = 0;
+	reader->lineNumber = 0;
+	reader->linesCounted = true;
+	reader->truncated = false;
+	reader->quiet = false;
+	reader->errorCount = 0;
+}
+
+bool seekFile(FILE *file, uint64_t offset)
+{
+#ifdef _WIN32
+	return _fseeki64(file, (__int64)offset, SEEK_SET) == 0;
+#else
+	return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+bool seekStudentReader(StudentReader *reader, uint64_t offset)
+{
+	reader->size = 0;
+	reader->position = 0;
+	reader->bufferOffset = offset;
+	reader->lineNumber = 0;
+	reader->linesCounted = offset == 0;
+	return seekFile(reader->stream, offset);
+}
+
+uint64_t tellFile(FILE *file)
+{
+#ifdef _WIN32
+	return (uint64_t)_ftelli64(file);
+#else
+	return (uint64_t)ftello(file);
+#endif
+}
+
+/*
+ * Размер файла без ограничения long (файлы больше 2 ГБ); после вызова
+ * файл установлен на начало.
+ */
+uint64_t getFileSize(FILE *file)
+{
+#ifdef _WIN32
+	_fseeki64(file, 0, SEEK_END);
+#else
+	fseeko(file, 0, SEEK_END);
+#endif
+	uint64_t size = tellFile(file);
+	seekFile(file, 0);
+	return size;
+}
+
+uint64_t getStudentReaderOffset(const StudentReader *reader)
+{
+	return reader->bufferOffset + reader->position;
+}
+
+void closeStudentReader(StudentReader *reader)
+{
+	if (!reader->quiet && reader->errorCount > READER_ERROR_REPORT_LIMIT)
+	{
+		fprintf(stderr, "Еще записей с ошибками: %zu\n",
+		        reader->errorCount - READER_ERROR_REPORT_LIMIT);
+	}
+	free(reader->buffer);
+	reader->buffer = NULL;
+}
+
+bool fillStudentReader(StudentReader *reader)
+{
+	reader->bufferOffset += reader->size;
+	reader->size = fread(reader->buffer, 1, READER_BUFFER_SIZE,
+	                     reader->stream);
+	reader->position = 0;
+	return reader->size != 0;
+}
+
+/*
+ * Строка длиннее capacity - 1 обрезается, при этом устанавливается
+ * reader->truncated. Последняя строка файла может не заканчиваться
+ * переводом строки.
+ */
+bool readLine(StudentReader *reader, char *line, size_t capacity)
+{
+	size_t length = 0;
+	bool started = false;
+	reader->truncated = false;
+	while (true)
+	{
+		if (reader->position == reader->size && !fillStudentReader(reader))
+		{
+			if (started)
+			{
+				line[length] = '\0';
+				reader->lineNumber++;
+			}
+			return started;
+		}
+		started = true;
+		
+		const char *begin = reader->buffer + reader->position;
+		size_t available = reader->size - reader->position;
+		const char *newline = (const char *)memchr(begin, '\n', available);
+		size_t chunk = (newline != NULL) ? (size_t)(newline - begin)
+		                                 : available;
+		size_t copied = (chunk < capacity - 1 - length)
+		                ? chunk : capacity - 1 - length;
+		memcpy(line + length, begin, copied);
+		length += copied;
+		reader->position += chunk;
+		reader->truncated = reader->truncated || copied < chunk;
+		
+		if (newline != NULL)
+		{
+			reader->position++;
+			if (length != 0 && line[length - 1] == '\r')
+			{
+				length--;
+			}
+			line[length] = '\0';
+			reader->lineNumber++;
+			return true;
+		}
+	}
+}
+
+const char *skipBlanks(const char *text)
+{
+	while (*text == ' ' || *text == '\t')
+	{
+		text++;
+	}
+	return text;
+}
+
+const char *parseStringField(char *field, const char *text)
+{
+	strcpy(field, text);
+	return NULL;
+}
+
+const char *parseIntField(int *field, const char *text,
+                          StudentFieldRange range)
+{
+	const char *c = skipBlanks(text);
+	bool negative = *c == '-';
+	if (*c == '-' || *c == '+')
+	{
+		c++;
+	}
+	if (*c < '0' || *c > '9')
+	{
+		return "ожидается целое число";
+	}
+	int64_t value = 0;
+	while (*c >= '0' && *c <= '9')
+	{
+		value = value * 10 + (*c++ - '0');
+		if (value > (int64_t)INT_MAX + 1)
+		{
+			return "значение вне допустимого диапазона";
+		}
+	}
+	if (*skipBlanks(c) != '\0')
+	{
+		return "ожидается целое число";
+	}
+	value = negative ? -value : value;
+	if (value < range.minimum || value > range.maximum)
+	{
+		return "значение вне допустимого диапазона";
+	}
+	*field = (int)value;
+	return NULL;
+}
+
+const char *parseRealField(double *field, const char *text,
+                           StudentFieldRange range)
+{
+	char *end;
+	double value = strtod(text, &end);
+	if (end == text || *skipBlanks(end) != '\0')
+	{
+		return "ожидается число";
+	}
+	if (!(value >= range.minimum && value <= range.maximum))
+	{
+		return "значение вне допустимого диапазона";
+	}
+	*field = value;
+	return NULL;
+}
+
+#define PARSE_STUDENT_FIELD(name, type, ...) \
+	case STUDENT_FIELD_##name: \
+		return PARSE_FIELD_##type(student->name, text, STUDENT_FIELD_##name);
+
+/*
+ * Разбирает значение поля field из text; при ошибке возвращает ее
+ * описание, а запись не изменяется.
+ */
+const char *parseStudentField(Student *student, int field, const char *text)
+{
+	switch (field)
+	{
+		STUDENT_FIELDS(PARSE_STUDENT_FIELD)
+		default:
+			return "нет такого поля";
+	}
+}
+
+/*
+ * Читает слово не длиннее STRING_BUFFER_MAX_SIZE - 1 символов, как
+ * scanf("%s"), но без выхода за пределы буфера.
+ */
+int scanString(char *s)
+{
+	char format[32];
+	snprintf(format, sizeof(format), "%%%ds", STRING_BUFFER_MAX_SIZE - 1);
+	return scanf(format, s);
+}
+
+/*
+ * Запрашивает значение поля, пока не будет введено допустимое; value -
+ * буфер для введенного текста. Возвращает false, если ввод закончился.
+ */
+bool scanStudentField(Student *student, int field, char *value)
+{
+	while (scanString(value) == 1)
+	{
+		const char *error = parseStudentField(student, field, value);
+		if (error == NULL)
+		{
+			return true;
+		}
+		printf("Ошибка: %s", error);
+		if (STUDENT_FIELD_DESCRIPTORS[field].type != FIELD_TYPE_STRING)
+		{
+			printf(" (допустимые значения от %.0lf до %.0lf)",
+			       STUDENT_FIELD_RANGES[field].minimum,
+			       STUDENT_FIELD_RANGES[field].maximum);
+		}
+		puts(". Введите значение еще раз:");
+	}
+	return false;
+}
+
+void reportStudentError(StudentReader *reader, const char *title,
+                        const char *error)
+{
+	if (++reader->errorCount > READER_ERROR_REPORT_LIMIT || reader->quiet)
+	{
+		return;
+	}
+	if (reader->linesCounted)
+	{
+		fprintf(stderr, "Строка %zu: ", reader->lineNumber);
+	}
+	fprintf(stderr, "%s: %s, запись пропущена.\n", title, error);
+}
+
+#define READ_STUDENT_FIELD(name, type, title, ...) \
+	if (error == NULL) \
+	{ \
+		bool read; \
+		do \
+		{ \
+			read = readLine(reader, line, sizeof(line)); \
+		} while (read && line[0] == '\0' && STUDENT_FIELD_##name == 0); \
+		errorTitle = title; \
+		if (!read) \
+		{ \
+			if (STUDENT_FIELD_##name != 0) \
+			{ \
+				reportStudentError(reader, "Запись", \
+				                   "файл закончился посреди записи"); \
+			} \
+			return false; \
+		} \
+		if (line[0] == '\0') \
+		{ \
+			error = "запись неполная"; \
+			separated = true; \
+		} \
+		else if (reader->truncated) \
+		{ \
+			error = "слишком длинная строка"; \
+		} \
+		else \
+		{ \
+			error = PARSE_FIELD_##type(student->name, line, \
+			                           STUDENT_FIELD_##name); \
+		} \
+	}
+
+/*
+ * Читает следующую корректную запись. Записи с ошибками (слишком длинные
+ * строки, нечисловые значения, значения вне допустимого диапазона,
+ * неполные записи) пропускаются до следующей пустой строки с сообщением
+ * в stderr, в котором указан номер строки.
+ */
+bool readStudent(StudentReader *reader, Student *student)
+{
+	char line[STRING_BUFFER_MAX_SIZE];
+	while (true)
+	{
+		const char *error = NULL;
+		const char *errorTitle = NULL;
+		bool separated = false;
+		STUDENT_FIELDS(READ_STUDENT_FIELD)
+		if (error == NULL)
+		{
+			if (!readLine(reader, line, sizeof(line)) || line[0] == '\0')
+			{
+				return true;
+			}
+			errorTitle = "Запись";
+			error = "после записи ожидается пустая строка";
+		}
+		
+		reportStudentError(reader, errorTitle, error);
+		while (!separated && readLine(reader, line, sizeof(line)))
+		{
+			separated = line[0] == '\0';
+		}
+	}
+}
+
+/*
+ * Необязательная первая строка файла записей "#sorted <критерий> <n>":
+ * первые n записей упорядочены по критерию сортировки, а записи после них
+ * добавлены позже и еще не встроены в этот порядок.
+ */
+void readNotesOrder(StudentReader *reader, NotesOrder *order)
+{
+	order->criterion = 0;
+	order->sortedCount = 0;
+	
+	size_t length = strlen(NOTES_ORDER_HEADER);
+	char line[STRING_BUFFER_MAX_SIZE];
+	if ((reader->position < reader->size || fillStudentReader(reader)) &&
+	    reader->size - reader->position >= length &&
+	    memcmp(reader->buffer + reader->position, NOTES_ORDER_HEADER,
+	           length) == 0 &&
+	    readLine(reader, line, sizeof(line)))
+	{
+		int criterion = 0;
+		size_t sortedCount = 0;
+		if (sscanf(line + length, "%d %zu", &criterion, &sortedCount) == 2 &&
+		    1 <= criterion && criterion <= STUDENT_SORT_CRITERION_COUNT)
+		{
+			order->criterion = criterion;
+			order->sortedCount = sortedCount;
+		}
+	}
+}
+
+#define ALLOCATE_STUDENT_COLUMN(name, ...) \
+	columns->name = malloc((capacity + 1) * sizeof(*columns->name)); \
+	allocated = allocated && columns->name != NULL;
+#define FILL_STUDENT_COLUMN(name, ...) \
+	for (size_t i = 0; i < students.size; i++) \
+	{ \
+		columns->name[i] = students.data[i].name; \
+	}
+#define FREE_STUDENT_COLUMN(name, ...) \
+	free((void *)columns->name); \
+	columns->name = NULL;
+
+void deleteStudentColumns(StudentColumns *columns)
+{
+	STUDENT_FIELDS(FREE_STUDENT_COLUMN)
+	columns->size = 0;
+}
+
+/*
+ * Выделяет пустые столбцы на capacity записей. Возвращает false, если
+ * памяти не хватило; выделенные столбцы при этом освобождаются.
+ */
+bool allocateStudentColumns(StudentColumns *columns, size_t capacity)
+{
+	bool allocated = true;
+	columns->size = 0;
+	STUDENT_FIELDS(ALLOCATE_STUDENT_COLUMN)
+	if (!allocated)
+	{
+		deleteStudentColumns(columns);
+	}
+	return allocated;
+}
+
+/*
+ * Строковые столбцы указывают на строки students, поэтому записи должны
+ * жить, пока используются столбцы.
+ */
+void fillStudentColumns(StudentColumns *columns, StudentArray students)
+{
+	columns->size = students.size;
+	STUDENT_FIELDS(FILL_STUDENT_COLUMN)
+}
+
+bool getStudentColumns(StudentArray students, StudentColumns *columns)
+{
+	if (!allocateStudentColumns(columns, students.size))
+	{
+		return false;
+	}
+	fillStudentColumns(columns, students);
+	return true;
+}
+
+/*
+ * Если память под буфер выделить не удалось, используется небольшой
+ * встроенный буфер reserve: вывод остается правильным, но пишется в поток
+ * меньшими порциями.
+ */
+void openOutputBuffer(OutputBuffer *output, FILE *stream)
+{
+	output->stream = stream;
+	output->data = (char *)malloc(OUTPUT_BUFFER_SIZE);
+	output->capacity = OUTPUT_BUFFER_SIZE;
+	if (output->data == NULL)
+	{
+		output->data = output->reserve;
+		output->capacity = OUTPUT_BUFFER_MIN_SIZE;
+	}
+	output->size = 0;
+	output->decimalPoint = localeconv()->decimal_point[0];
+}
+
+void writeToStream(FILE *stream, const char *data, size_t size)
+{
+	fflush(stream);
+	int descriptor = fileno(stream);
+	while (size != 0)
+	{
+#ifdef _WIN32
+		int written = _write(descriptor, data,
+		                     (size > INT_MAX) ? INT_MAX : (unsigned)size);
+#else
+		ssize_t written = write(descriptor, data, size);
+#endif
+		if (written <= 0)
+		{
+			fwrite(data, 1, size, stream);
+			return;
+		}
+		data += written;
+		size -= (size_t)written;
+	}
+}
+
+void flushOutputBuffer(OutputBuffer *output)
+{
+	writeToStream(output->stream, output->data, output->size);
+	output->size = 0;
+}
+
+void closeOutputBuffer(OutputBuffer *output)
+{
+	flushOutputBuffer(output);
+	if (output->data != output->reserve)
+	{
+		free(output->data);
+	}
+	output->data = NULL;
+}
+
+char *reserveOutput(OutputBuffer *output, size_t length)
+{
+	if (output->size + length > output->capacity)
+	{
+		flushOutputBuffer(output);
+	}
+	return output->data + output->size;
+}
+
+void outputBytes(OutputBuffer *output, const char *bytes, size_t length)
+{
+	if (length > output->capacity)
+	{
+		flushOutputBuffer(output);
+		writeToStream(output->stream, bytes, length);
+		return;
+	}
+	memcpy(reserveOutput(output, length), bytes, length);
+	output->size += length;
+}
+
+void outputString(OutputBuffer *output, const char *s)
+{
+	outputBytes(output, s, strlen(s));
+}
+
+char *formatUnsigned(char *end, uint64_t value)
+{
+	do
+	{
+		*--end = (char)('0' + value % 10);
+		value /= 10;
+	} while (value != 0);
+	return end;
+}
+
+void outputInt(OutputBuffer *output, int value)
+{
+	char digits[16];
+	char *end = digits + sizeof(digits);
+	uint64_t magnitude = (value < 0) ? 0 - (uint64_t)(int64_t)value
+	                                 : (uint64_t)value;
+	char *begin = formatUnsigned(end, magnitude);
+	if (value < 0)
+	{
+		*--begin = '-';
+	}
+	outputBytes(output, begin, (size_t)(end - begin));
+}
+
+/*
+ * Аналог "%lf" (шесть знаков после запятой). Значения, для которых
+ * округление через умножение может разойтись с printf (очень большие
+ * и лежащие почти посередине между соседними результатами), печатаются
+ * через snprintf.
+ */
+void outputFixed(OutputBuffer *output, double value)
+{
+	double scaled = (signbit(value) ? -value : value) * 1e6;
+	double fraction = (scaled < 1e9) ? scaled - (double)(uint64_t)scaled : 0;
+	if (!(scaled < 1e9) || (fraction > 0.5 - 1e-6 && fraction < 0.5 + 1e-6))
+	{
+		char text[STRING_BUFFER_MAX_SIZE];
+		snprintf(text, sizeof(text), "%lf", value);
+		char *point = strchr(text, localeconv()->decimal_point[0]);
+		if (point != NULL)
+		{
+			*point = output->decimalPoint;
+		}
+		outputString(output, text);
+		return;
+	}
+	
+	uint64_t rounded = (uint64_t)(scaled + 0.5);
+	char digits[32];
+	char *end = digits + sizeof(digits);
+	char *begin = end;
+	uint64_t fractionDigits = rounded % 1000000;
+	for (int i = 0; i < 6; i++)
+	{
+		*--begin = (char)('0' + fractionDigits % 10);
+		fractionDigits /= 10;
+	}
+	*--begin = output->decimalPoint;
+	begin = formatUnsigned(begin, rounded / 1000000);
+	if (signbit(value))
+	{
+		*--begin = '-';
+	}
+	outputBytes(output, begin, (size_t)(end - begin));
+}
+
+#define OUTPUT_STUDENT_FIELD(name, type, ...) \
+	OUTPUT_FIELD_##type(output, student->name); \
+	outputBytes(output, "\n", 1);
+#define OUTPUT_STUDENT_FIELD_VIEW(name, type, title, ...) \
+	outputString(output, title ": "); \
+	OUTPUT_FIELD_##type(output, student->name); \
+	outputBytes(output, "\n", 1);
+
+void outputStudent(OutputBuffer *output, const Student *student)
+{
+	STUDENT_FIELDS(OUTPUT_STUDENT_FIELD)
+	outputBytes(output, "\n", 1);
+}
+
+void outputStudentView(OutputBuffer *output, const Student *student)
+{
+	STUDENT_FIELDS(OUTPUT_STUDENT_FIELD_VIEW)
+	outputBytes(output, "\n", 1);
+}
+
+void writeStudentsToFile(FILE *notes, StudentArray students)
+{
+	PROFILE_BEGIN(PROFILE_WRITE_STUDENTS);
+	OutputBuffer output;
+	openOutputBuffer(&output, notes);
+	for (size_t i = 0; i < students.size; i++)
+	{
+		outputStudent(&output, &students.data[i]);
+	}
+	closeOutputBuffer(&output);
+	PROFILE_END(PROFILE_WRITE_STUDENTS, students.size);
+}
+
+void writeSortedStudentsToFile(FILE *notes, StudentArray students,
+                               int criterion)
+{
+	if (criterion != 0)
+	{
+		fprintf(notes, NOTES_ORDER_HEADER " %d %zu\n", criterion,
+		        students.size);
+	}
+	writeStudentsToFile(notes, students);
+}
+
+void readFile(FILE *file)
+{
+	char current;
+	while ((current = (char)fgetc(file)) != EOF)
+	{
+		printf("%c", current);
+	}
+}
+
+void swapStudents(Student *s1, Student *s2)
+{
+	PROFILE_BEGIN(PROFILE_SWAP_STUDENTS);
+	if (s1 != s2)
+	{
+		Student tmp;
+		copyStudent(&tmp, s1);
+		copyStudent(s1, s2);
+		copyStudent(s2, &tmp);
+	}
+	PROFILE_END(PROFILE_SWAP_STUDENTS, 1);
+}
+
+void createFile(const char *fileName)
+{
+	FILE *f = fopen(fileName, "w");
+	fclose(f);
+	puts("Файл создан.\n");
+}
+
+void viewFile(StudentArray students)
+{
+	OutputBuffer output;
+	openOutputBuffer(&output, stdout);
+	for (size_t i = 0; i < students.size; i++)
+	{
+		outputStudentView(&output, &students.data[i]);
+	}
+	closeOutputBuffer(&output);
+}
+
+bool scanNote(Student *student,
+              char values[STUDENT_FIELD_COUNT][STRING_BUFFER_MAX_SIZE])
+{
+	for (int field = 0; field < STUDENT_FIELD_COUNT; field++)
+	{
+		puts(STUDENT_FIELD_PROMPTS[field]);
+		if (!scanStudentField(student, field, values[field]))
+		{
+			puts("Запись не добавлена.\n");
+			return false;
+		}
+	}
+	return true;
+}
+
+void writeNote(FILE *notes,
+               char values[STUDENT_FIELD_COUNT][STRING_BUFFER_MAX_SIZE])
+{
+	for (int field = 0; field < STUDENT_FIELD_COUNT; field++)
+	{
+		fprintf(notes, "%s\n", values[field]);
+	}
+	fputs("\n", notes);
+}
+
+void addNote(FILE *notes)
+{
+	char values[STUDENT_FIELD_COUNT][STRING_BUFFER_MAX_SIZE];
+	Student student;
+	if (scanNote(&student, values))
+	{
+		writeNote(notes, values);
+		puts("Запись добавлена.\n");
+	}
+}
+
+bool isIndividualTaskStudent(Student s)
+{
+	return (s.physicsGrade == 4 || s.physicsGrade == 5) &&
+	       (s.mathsGrade > 8 && s.informaticsGrade > 8);
+}
+
+void writeIndividualTask(FILE *output, StudentArray students)
+{
+	PROFILE_BEGIN(PROFILE_INDIVIDUAL_TASK);
+	OutputBuffer buffer;
+	openOutputBuffer(&buffer, output);
+	size_t matched = 0;
+	for (size_t i = 0; i < students.size; i++)
+	{
+		if (isIndividualTaskStudent(students.data[i]))
+		{
+			matched++;
+			outputStudentView(&buffer, &students.data[i]);
+		}
+	}
+	closeOutputBuffer(&buffer);
+	PROFILE_END(PROFILE_INDIVIDUAL_TASK, matched);
+}
+
+void solveIndividualTask(FILE *output, StudentArray students)
+{
+	writeIndividualTask(output, students);
+	puts("Решение индивидуального задания записано в файл.\n");
+}
+
+size_t findStudent(StudentArray students, const char *surname)
+{
+	PROFILE_BEGIN(PROFILE_FIND_STUDENT);
+	size_t i = 0;
+	while (i < students.size && strcmp(students.data[i].surname, surname) != 0)
+	{
+		i++;
+	}
+	PROFILE_END(PROFILE_FIND_STUDENT, (i != students.size) ? 1 : 0);
+	return i;
+}
+
+void removeStudent(StudentArray *students, size_t index)
+{
+	swapStudents(&students->data[index], &students->data[students->size - 1]);
+	removeLastStudent(students);
+}
+
+#define EDIT_STUDENT_FIELD(name, type, title, prompt, editPrompt) \
+	case STUDENT_FIELD_##name: \
+		puts(editPrompt); \
+		scanStudentField(student, STUDENT_FIELD_##name, value); \
+		return true;
+
+bool editStudentField(Student *student, int field)
+{
+	char value[STRING_BUFFER_MAX_SIZE];
+	switch (field)
+	{
+		STUDENT_FIELDS(EDIT_STUDENT_FIELD)
+		default:
+			return false;
+	}
+}
+
+void editNote(StudentArray *students)
+{
+	puts("Введите фамилию студента, информацию о котором необходимо "
+		 "редактировать:");
+	char changingStudentsSurname[STRING_BUFFER_MAX_SIZE];
+	scanString(changingStudentsSurname);
+	
+	for (size_t i = 0; i < students->size; i++)
+	{
+		if (strcmp(students->data[i].surname, changingStudentsSurname) == 0)
+		{
+			int option = 1;
+			while (1 <= option && option <= STUDENT_FIELD_COUNT)
+			{
+				puts("Выберите информацию о студенте, которую хотите "
+				     "редактировать:");
+				for (int field = 0; field < STUDENT_FIELD_COUNT; field++)
+				{
+					printf("%d. %s.\n", field + 1, STUDENT_FIELD_TITLES[field]);
+				}
+				puts("Любое другое число - выход из режима изменения");
+				
+				scanf("%d", &option);
+				
+				if (!editStudentField(&students->data[i], option - 1))
+				{
+					puts("Выход из режимы изменения...");
+				}
+			}
+			puts("Запись изменена.\n");
+			return;
+		}
+	}
+	puts("Нет такого студента!\n");
+}
+
+void removeNote(StudentArray *students)
+{
+	puts("Введите фамилию студента, информацию о котором необходимо "
+	     "удалить (после удаления информации порядок следования студентов "
+		 "в файле может быть нарушен):");
+	char removingStudentsSurname[STRING_BUFFER_MAX_SIZE];
+	scanString(removingStudentsSurname);
+	
+	size_t i = findStudent(*students, removingStudentsSurname);
+	if (i != students->size)
+	{
+		removeStudent(students, i);
+		puts("Запись удалена.\n");
+		return;
+	}
+	puts("Нет такого студента!\n");
+}
+
+#define CHECK_SORT_CRITERION(number, field, order, relation, title) \
+	case number: \
+		return compareStudentsBy_##field(s1, s2) relation 0;
+
+bool isSorted(const Student *s1, const Student *s2, int criterion)
+{
+	switch (criterion)
+	{
+		STUDENT_SORT_CRITERIA(CHECK_SORT_CRITERION)
+		default:
+			return false; // never get there
+	}
+}
+
+bool isSortedRange(const Student *students, size_t count, int criterion)
+{
+	for (size_t i = 1; i < count; i++)
+	{
+		if (isSorted(&students[i], &students[i - 1], criterion))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * Устойчивая сортировка слиянием для каждого числового критерия: упорядочиваются
+ * указатели на записи (сравнение - функция сравнения поля), затем записи
+ * переставляются за один проход, так что каждая запись копируется один
+ * раз.
+ */
+#define DEFINE_STUDENT_SORT(number, field, order, relation, title) \
+void mergeStudentsBy_##field##_##order(const Student **links, \
+                                       const Student **scratch, size_t count) \
+{ \
+	if (count < 2) \
+	{ \
+		return; \
+	} \
+	size_t middle = count / 2; \
+	mergeStudentsBy_##field##_##order(links, scratch, middle); \
+	mergeStudentsBy_##field##_##order(links + middle, scratch, \
+	                                  count - middle); \
+	 \
+	memcpy(scratch, links, middle * sizeof(const Student *)); \
+	size_t left = 0; \
+	size_t right = middle; \
+	size_t position = 0; \
+	while (left < middle) \
+	{ \
+		if (right < count && \
+		    compareStudentsBy_##field(links[right], scratch[left]) relation 0) \
+		{ \
+			links[position++] = links[right++]; \
+		} \
+		else \
+		{ \
+			links[position++] = scratch[left++]; \
+		} \
+	} \
+} \
+ \
+bool sortStudentsBy_##field##_##order(StudentArray *students) \
+{ \
+	size_t count = students->size; \
+	const Student **links = (const Student **)malloc( \
+		(count + 1) * sizeof(const Student *)); \
+	const Student **scratch = (const Student **)malloc( \
+		(count / 2 + 1) * sizeof(const Student *)); \
+	Student *sorted = (Student *)malloc((count + 1) * sizeof(Student)); \
+	if (links == NULL || scratch == NULL || sorted == NULL) \
+	{ \
+		free(links); \
+		free(scratch); \
+		free(sorted); \
+		return false; \
+	} \
+	for (size_t i = 0; i < count; i++) \
+	{ \
+		links[i] = &students->data[i]; \
+	} \
+	mergeStudentsBy_##field##_##order(links, scratch, count); \
+	free(scratch); \
+	 \
+	for (size_t i = 0; i < count; i++) \
+	{ \
+		memcpy(&sorted[i], links[i], sizeof(Student)); \
+	} \
+	free(links); \
+	free(students->data); \
+	students->data = sorted; \
+	return true; \
+}
+#define DISPATCH_STUDENT_SORT(number, field, order, relation, title) \
+	case number: \
+		sorted = sortStudentsBy_##field##_##order(students); \
+		break;
+
+STUDENT_NUMERIC_SORT_CRITERIA(DEFINE_STUDENT_SORT)
+
+int compareCollationKeys(const CollationKey *k1, const CollationKey *k2)
+{
+	size_t length = (k1->length < k2->length) ? k1->length : k2->length;
+	int order = memcmp(k1->key, k2->key, length);
+	if (order != 0)
+	{
+		return order;
+	}
+	return (k1->length > k2->length) - (k1->length < k2->length);
+}
+
+void sortCollationKeys(CollationKey *keys, CollationKey *scratch, size_t count,
+                       int sign)
+{
+	if (count < 2)
+	{
+		return;
+	}
+	size_t middle = count / 2;
+	sortCollationKeys(keys, scratch, middle, sign);
+	sortCollationKeys(keys + middle, scratch, count - middle, sign);
+	
+	memcpy(scratch, keys, middle * sizeof(CollationKey));
+	size_t left = 0;
+	size_t right = middle;
+	size_t position = 0;
+	while (left < middle)
+	{
+		if (right < count &&
+		    sign * compareCollationKeys(&keys[right], &scratch[left]) < 0)
+		{
+			keys[position++] = keys[right++];
+		}
+		else
+		{
+			keys[position++] = scratch[left++];
+		}
+	}
+}
+
+/*
+ * Сортировка по строковому полю: ключ сопоставления строится один раз для
+ * каждой записи, затем устойчивой сортировкой слиянием упорядочиваются
+ * ключи (сравнение memcmp), и записи переставляются за один проход.
+ */
+bool sortStudentsByCollationKey(StudentArray *students, int criterion)
+{
+	int field = STUDENT_SORT_CRITERION_FIELDS[criterion - 1];
+	size_t count = students->size;
+	size_t keySize = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		keySize += 4 * strlen(CONST_STUDENT_FIELD_AT(&students->data[i],
+		                                             field, char)) + 2;
+	}
+	unsigned char *keyBytes = (unsigned char *)malloc(keySize + 1);
+	CollationKey *keys = (CollationKey *)malloc((count + 1) *
+	                                            sizeof(CollationKey));
+	CollationKey *scratch = (CollationKey *)malloc((count / 2 + 1) *
+	                                               sizeof(CollationKey));
+	Student *sorted = (Student *)malloc((count + 1) * sizeof(Student));
+	if (keyBytes == NULL || keys == NULL || scratch == NULL || sorted == NULL)
+	{
+		free(keyBytes);
+		free(keys);
+		free(scratch);
+		free(sorted);
+		return false;
+	}
+	unsigned char *key = keyBytes;
+	for (size_t i = 0; i < count; i++)
+	{
+		keys[i].key = key;
+		keys[i].length = getCollationKey(
+			CONST_STUDENT_FIELD_AT(&students->data[i], field, char), key);
+		keys[i].index = i;
+		key += keys[i].length;
+	}
+	sortCollationKeys(keys, scratch, count,
+	                  STUDENT_SORT_CRITERION_SIGNS[criterion - 1]);
+	free(scratch);
+	free(keyBytes);
+	
+	for (size_t i = 0; i < count; i++)
+	{
+		memcpy(&sorted[i], &students->data[keys[i].index], sizeof(Student));
+	}
+	free(keys);
+	free(students->data);
+	students->data = sorted;
+	return true;
+}
+
+/*
+ * Возвращает false, если для сортировки не хватило памяти; записи при этом
+ * остаются в прежнем порядке.
+ */
+bool sortStudents(StudentArray *students, int criterion)
+{
+	PROFILE_BEGIN(PROFILE_SORT_STUDENTS);
+	bool sorted = false;
+	switch (criterion)
+	{
+		STUDENT_NUMERIC_SORT_CRITERIA(DISPATCH_STUDENT_SORT)
+		default:
+			sorted = sortStudentsByCollationKey(students, criterion);
+	}
+	PROFILE_END(PROFILE_SORT_STUDENTS, students->size);
+	return sorted;
+}
+
+void sortStudentRange(Student *students, Student *scratch, size_t count,
+                      int criterion)
+{
+	if (count < 2)
+	{
+		return;
+	}
+	size_t middle = count / 2;
+	sortStudentRange(students, scratch, middle, criterion);
+	sortStudentRange(students + middle, scratch, count - middle, criterion);
+	
+	memcpy(scratch, students, middle * sizeof(Student));
+	size_t left = 0;
+	size_t right = middle;
+	size_t position = 0;
+	while (left < middle)
+	{
+		if (right < count && isSorted(&students[right], &scratch[left],
+		                              criterion))
+		{
+			memcpy(&students[position++], &students[right++],
+			       sizeof(Student));
+		}
+		else
+		{
+			memcpy(&students[position++], &scratch[left++], sizeof(Student));
+		}
+	}
+}
+
+/*
+ * Встраивает записи [sortedCount, size) в упорядоченное начало массива:
+ * добавленные записи сортируются слиянием, затем с конца для каждой из
+ * них двоичным поиском находится место, и блок упорядоченных записей за
+ * ним сдвигается одним memmove. Сравнений O(k log n) для k добавленных
+ * записей, каждая упорядоченная запись сдвигается не более одного раза.
+ * Если памяти не хватило, возвращает false, не меняя массив.
+ */
+bool mergeStudentTail(StudentArray *students, size_t sortedCount,
+                      int criterion)
+{
+	size_t tailCount = students->size - sortedCount;
+	Student *tail = (Student *)malloc(tailCount * sizeof(Student));
+	Student *scratch = (Student *)malloc(tailCount * sizeof(Student));
+	if (tail == NULL || scratch == NULL)
+	{
+		free(scratch);
+		free(tail);
+		return false;
+	}
+	memcpy(tail, students->data + sortedCount, tailCount * sizeof(Student));
+	sortStudentRange(tail, scratch, tailCount, criterion);
+	free(scratch);
+	
+	Student *data = students->data;
+	size_t end = sortedCount;
+	for (size_t j = tailCount; j-- > 0;)
+	{
+		size_t low = 0;
+		size_t high = end;
+		while (low < high)
+		{
+			size_t middle = low + (high - low) / 2;
+			if (isSorted(&tail[j], &data[middle], criterion))
+			{
+				high = middle;
+			}
+			else
+			{
+				low = middle + 1;
+			}
+		}
+		memmove(&data[low + j + 1], &data[low], (end - low) * sizeof(Student));
+		memcpy(&data[low + j], &tail[j], sizeof(Student));
+		end = low;
+	}
+	free(tail);
+	return true;
+}
+
+/*
+ * Возвращает выбранный критерий сортировки или currentCriterion, если
+ * сортировка не производилась. Записи, уже упорядоченные по выбранному
+ * критерию, повторно не сортируются.
+ */
+int sortNotes(StudentArray *students, int currentCriterion)
+{
+	puts("Выберите критерий, по которому будет проводиться сортировка:");
+	for (int criterion = 1; criterion <= STUDENT_SORT_CRITERION_COUNT;
+	     criterion++)
+	{
+		printf("%d. %s.\n", criterion,
+		       STUDENT_SORT_CRITERION_TITLES[criterion - 1]);
+	}
+	puts("Любое другое число - сортировка не производится.");
+	int option;
+	scanf("%d", &option);
+	
+	if (1 <= option && option <= STUDENT_SORT_CRITERION_COUNT)
+	{
+		if (option != currentCriterion &&
+		    !isSortedRange(students->data, students->size, option) &&
+		    !sortStudents(students, option))
+		{
+			puts("Недостаточно памяти для сортировки!\n");
+			return currentCriterion;
+		}
+		puts("Сортировка выполнена.\n");
+		return option;
+	}
+	puts("Выход из режима сортировки...\n");
+	return currentCriterion;
+}
+
+/*
+ * Записи, добавленные в конец упорядоченного файла, встраиваются в порядок
+ * при чтении. Число упорядоченных записей из заголовка не доверяется
+ * (отклоненная запись сдвигает границу), поэтому упорядоченным считается
+ * наибольшее проверенное начало в его пределах. В order возвращается
+ * критерий (или 0) и длина этого начала, в errorCount (если он задан) -
+ * число отклоненных записей.
+ */
+StudentArray loadStudentsWithOrder(FILE *notes, NotesOrder *order,
+                                   size_t *errorCount)
+{
+	PROFILE_BEGIN(PROFILE_GET_STUDENTS);
+	
+	StudentArray students;
+	students.size = 0;
+	students.data = NULL;
+	
+	StudentReader reader;
+	openStudentReader(&reader, notes);
+	readNotesOrder(&reader, order);
+	size_t capacity = 0;
+	Student currentStudent;
+	while (readStudent(&reader, &currentStudent))
+	{
+		if (!addStudent(&students, &capacity, &currentStudent))
+		{
+			/*
+			 * Прочитанные записи потом записываются обратно в файл, поэтому
+			 * вернуть только часть из них нельзя.
+			 */
+			printf("Строка %zu: недостаточно памяти для загрузки %zu-й "
+			       "записи!\n", reader.lineNumber, students.size + 1);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (errorCount != NULL)
+	{
+		*errorCount = reader.errorCount;
+	}
+	closeStudentReader(&reader);
+	
+	if (order->criterion != 0 && order->sortedCount > students.size)
+	{
+		fprintf(stderr, "Заголовок: упорядоченных записей %zu, а корректных "
+		        "записей в файле %zu, порядок будет проверен заново.\n",
+		        order->sortedCount, students.size);
+		order->sortedCount = students.size;
+	}
+	if (order->criterion != 0 && order->sortedCount > 0)
+	{
+		size_t sortedCount = 1;
+		while (sortedCount < order->sortedCount &&
+		       !isSorted(&students.data[sortedCount],
+		                 &students.data[sortedCount - 1], order->criterion))
+		{
+			sortedCount++;
+		}
+		order->sortedCount = sortedCount;
+	}
+	if (order->criterion != 0 && order->sortedCount < students.size &&
+	    !mergeStudentTail(&students, order->sortedCount, order->criterion))
+	{
+		fprintf(stderr, "Недостаточно памяти, чтобы упорядочить добавленные "
+		        "записи, порядок не учитывается.\n");
+		order->criterion = 0;
+	}
+	
+	PROFILE_END(PROFILE_GET_STUDENTS, students.size);
+	return students;
+}
+
+/*
+ * В sortCriterion (если он задан) возвращается критерий, по которому
+ * упорядочены прочитанные записи, или 0.
+ */
+StudentArray getStudentsWithOrder(FILE *notes, int *sortCriterion)
+{
+	NotesOrder order;
+	StudentArray students = loadStudentsWithOrder(notes, &order, NULL);
+	if (sortCriterion != NULL)
+	{
+		*sortCriterion = order.criterion;
+	}
+	return students;
+}
+
+StudentArray getStudents(FILE *notes)
+{
+	return getStudentsWithOrder(notes, NULL);
+}
+
+/*
+ * Загружает файл записей для просмотра. Если в конце упорядоченного файла
+ * больше NOTES_TAIL_REWRITE_THRESHOLD добавленных записей, то файл
+ * перезаписывается в уже встроенном порядке, чтобы не встраивать их при
+ * каждом чтении. Файл с отклоненными записями не перезаписывается, чтобы
+ * их не потерять. Содержимое файла для истории версий при этом не
+ * меняется: она хранит записи в порядке после встраивания.
+ */
+StudentArray loadNotes(const char *fileName)
+{
+	StudentArray students = { NULL, 0 };
+	FILE *notes = fopen(fileName, "r");
+	if (notes == NULL)
+	{
+		puts("Не удалось открыть файл записей!\n");
+		return students;
+	}
+	NotesOrder order;
+	size_t errorCount;
+	students = loadStudentsWithOrder(notes, &order, &errorCount);
+	fclose(notes);
+	
+	if (order.criterion != 0 && errorCount == 0 &&
+	    students.size - order.sortedCount > NOTES_TAIL_REWRITE_THRESHOLD)
+	{
+		notes = fopen(fileName, "w");
+		if (notes != NULL)
+		{
+			writeSortedStudentsToFile(notes, students, order.criterion);
+			fclose(notes);
+		}
+	}
+	return students;
+}
+
+void putBytes(ByteBuffer *buffer, const void *bytes, size_t count)
+{
+	if (buffer->size + count > buffer->capacity)
+	{
+		size_t capacity = (buffer->capacity == 0) ? 64 : buffer->capacity;
+		while (buffer->size + count > capacity)
+		{
+			capacity *= 2;
+		}
+		buffer->data = (unsigned char *)realloc(buffer->data, capacity);
+		buffer->capacity = capacity;
+	}
+	memcpy(buffer->data + buffer->size, bytes, count);
+	buffer->size += count;
+}
+
+void putByte(ByteBuffer *buffer, unsigned char byte)
+{
+	putBytes(buffer, &byte, 1);
+}
+
+void putVarint(ByteBuffer *buffer, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		putByte(buffer, (unsigned char)(value | 0x80));
+		value >>= 7;
+	}
+	putByte(buffer, (unsigned char)value);
+}
+
+void storeUint32(unsigned char *bytes, uint32_t value)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		bytes[i] = (unsigned char)(value >> (8 * i));
+	}
+}
+
+void storeUint64(unsigned char *bytes, uint64_t value)
+{
+	for (int i = 0; i < 8; i++)
+	{
+		bytes[i] = (unsigned char)(value >> (8 * i));
+	}
+}
+
+uint32_t loadUint32(const unsigned char *bytes)
+{
+	uint32_t value = 0;
+	for (int i = 3; i >= 0; i--)
+	{
+		value = (value << 8) | bytes[i];
+	}
+	return value;
+}
+
+uint64_t loadUint64(const unsigned char *bytes)
+{
+	uint64_t value = 0;
+	for (int i = 7; i >= 0; i--)
+	{
+		value = (value << 8) | bytes[i];
+	}
+	return value;
+}
+
+void putUint64(ByteBuffer *buffer, uint64_t value)
+{
+	unsigned char bytes[8];
+	storeUint64(bytes, value);
+	putBytes(buffer, bytes, sizeof(bytes));
+}
+
+uint64_t zigzagEncode(int64_t value)
+{
+	return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+int64_t zigzagDecode(uint64_t value)
+{
+	return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+const unsigned char *getBytes(ByteReader *reader, size_t count)
+{
+	if (reader->failed || reader->size - reader->position < count)
+	{
+		reader->failed = true;
+		return NULL;
+	}
+	const unsigned char *bytes = reader->data + reader->position;
+	reader->position += count;
+	return bytes;
+}
+
+unsigned char getByte(ByteReader *reader)
+{
+	const unsigned char *byte = getBytes(reader, 1);
+	return (byte != NULL) ? *byte : 0;
+}
+
+uint64_t getVarint(ByteReader *reader)
+{
+	uint64_t value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		unsigned char byte = getByte(reader);
+		value |= (uint64_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			return value;
+		}
+	}
+	reader->failed = true;
+	return 0;
+}
+
+bool isPackableColumn(const Student *students, size_t count, int field)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		int value = *CONST_STUDENT_FIELD_AT(&students[i], field, int);
+		if (value < 0 || value > 15)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool isFixedColumn(const Student *students, size_t count, int field)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		double value = *CONST_STUDENT_FIELD_AT(&students[i], field, double);
+		double scaled = value * 100;
+		if (!(0 <= scaled && scaled < 1e9) ||
+		    (double)(int64_t)(scaled + 0.5) / 100 != value)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void encodeStringColumn(ByteBuffer *block, const Student *students,
+                        size_t count, int field)
+{
+	const char *previous = "";
+	for (size_t i = 0; i < count; i++)
+	{
+		const char *value = CONST_STUDENT_FIELD_AT(&students[i], field, char);
+		size_t prefixLength = 0;
+		while (previous[prefixLength] != '\0' &&
+		       previous[prefixLength] == value[prefixLength])
+		{
+			prefixLength++;
+		}
+		size_t suffixLength = strlen(value + prefixLength);
+		putVarint(block, prefixLength);
+		putVarint(block, suffixLength);
+		putBytes(block, value + prefixLength, suffixLength);
+		previous = value;
+	}
+}
+
+void encodeIntColumn(ByteBuffer *block, const Student *students,
+                     size_t count, int field, bool packed)
+{
+	int64_t previous = 0;
+	unsigned char pendingByte = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		int value = *CONST_STUDENT_FIELD_AT(&students[i], field, int);
+		if (!packed)
+		{
+			putVarint(block, zigzagEncode(value - previous));
+			previous = value;
+		}
+		else if (i % 2 == 1)
+		{
+			putByte(block, (unsigned char)(pendingByte | (value << 4)));
+		}
+		else
+		{
+			pendingByte = (unsigned char)value;
+		}
+	}
+	if (packed && count % 2 == 1)
+	{
+		putByte(block, pendingByte);
+	}
+}
+
+void encodeRealColumn(ByteBuffer *block, const Student *students,
+                      size_t count, int field, bool fixed)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		double value = *CONST_STUDENT_FIELD_AT(&students[i], field, double);
+		if (fixed)
+		{
+			putVarint(block, (uint64_t)(value * 100 + 0.5));
+		}
+		else
+		{
+			uint64_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			putUint64(block, bits);
+		}
+	}
+}
+
+/*
+ * Блок архива: количество записей, флаги (по биту на поле), затем поля
+ * записей по столбцам в порядке STUDENT_FIELDS:
+ * строки - общий префикс с предыдущим значением и суффикс;
+ * целые - по 4 бита, если все значения блока помещаются в 4 бита,
+ * иначе разность с предыдущим значением;
+ * вещественные - в сотых долях, если это не теряет точности.
+ */
+void encodeArchiveBlock(ByteBuffer *block, const Student *students,
+                        size_t count)
+{
+	uint64_t flags = 0;
+	for (int field = 0; field < STUDENT_FIELD_COUNT; field++)
+	{
+		FieldType type = STUDENT_FIELD_DESCRIPTORS[field].type;
+		if ((type == FIELD_TYPE_INT &&
+		     isPackableColumn(students, count, field)) ||
+		    (type == FIELD_TYPE_REAL && isFixedColumn(students, count, field)))
+		{
+			flags |= (uint64_t)1 << field;
+		}
+	}
+	putVarint(block, count);
+	putVarint(block, flags);
+	
+	for (int field = 0; field < STUDENT_FIELD_COUNT; field++)
+	{
+		bool compact = (flags >> field) & 1;
+		switch (STUDENT_FIELD_DESCRIPTORS[field].type)
+		{
+			case FIELD_TYPE_STRING:
+				encodeStringColumn(block, students, count, field);
+				break;
+			case FIELD_TYPE_INT:
+				encodeIntColumn(block, students, count, field, compact);
+				break;
+			case FIELD_TYPE_REAL:
+				encodeRealColumn(block, students, count, field, compact);
+				break;
+		}
+	}
+}
+
+bool decodeStringColumn(ByteReader *block, Student *students, size_t count,
+                        int field)
+{
+	size_t previousLength = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		uint64_t prefixLength = getVarint(block);
+		uint64_t suffixLength = getVarint(block);
+		if (prefixLength > previousLength ||
+		    suffixLength >= STRING_BUFFER_MAX_SIZE - prefixLength)
+		{
+			return false;
+		}
+		const unsigned char *suffix = getBytes(block, (size_t)suffixLength);
+		if (suffix == NULL)
+		{
+			return false;
+		}
+		char *value = STUDENT_FIELD_AT(&students[i], field, char);
+		if (prefixLength != 0)
+		{
+			memcpy(value, STUDENT_FIELD_AT(&students[i - 1], field, char),
+			       (size_t)prefixLength);
+		}
+		memcpy(value + prefixLength, suffix, (size_t)suffixLength);
+		previousLength = (size_t)(prefixLength + suffixLength);
+		value[previousLength] = '\0';
+	}
+	return true;
+}
+
+bool decodeIntColumn(ByteReader *block, Student *students, size_t count,
+                     int field, bool packed)
+{
+	const unsigned char *packedValues = NULL;
+	if (packed)
+	{
+		packedValues = getBytes(block, (count + 1) / 2);
+		if (packedValues == NULL)
+		{
+			return false;
+		}
+	}
+	int64_t value = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (packed)
+		{
+			value = (i % 2 == 0) ? (packedValues[i / 2] & 0x0F)
+			                     : (packedValues[i / 2] >> 4);
+		}
+		else
+		{
+			value += zigzagDecode(getVarint(block));
+		}
+		*STUDENT_FIELD_AT(&students[i], field, int) = (int)value;
+	}
+	return true;
+}
+
+bool decodeRealColumn(ByteReader *block, Student *students, size_t count,
+                      int field, bool fixed)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		double *value = STUDENT_FIELD_AT(&students[i], field, double);
+		if (fixed)
+		{
+			*value = (double)getVarint(block) / 100;
+		}
+		else
+		{
+			const unsigned char *bytes = getBytes(block, 8);
+			uint64_t bits = (bytes != NULL) ? loadUint64(bytes) : 0;
+			memcpy(value, &bits, sizeof(bits));
+		}
+	}
+	return true;
+}
+
+bool decodeArchiveBlock(ByteReader *block, Student *students, size_t count)
+{
+	if (getVarint(block) != count)
+	{
+		return false;
+	}
+	uint64_t flags = getVarint(block);
+	
+	bool success = !block->failed;
+	for (int field = 0; success && field < STUDENT_FIELD_COUNT; field++)
+	{
+		bool compact = (flags >> field) & 1;
+		switch (STUDENT_FIELD_DESCRIPTORS[field].type)
+		{
+			case FIELD_TYPE_STRING:
+				success = decodeStringColumn(block, students, count, field);
+				break;
+			case FIELD_TYPE_INT:
+				success = decodeIntColumn(block, students, count, field,
+				                          compact);
+				break;
+			case FIELD_TYPE_REAL:
+				success = decodeRealColumn(block, students, count, field,
+				                           compact);
+				break;
+		}
+	}
+	
+	return success && !block->failed;
+}
+
+/*
+ * Архив: заголовок (сигнатура, размер блока, количество записей,
+ * количество блоков, смещение индекса), блоки записей и индекс -
+ * смещения начала каждого блока. Индекс позволяет прочитать одну запись,
+ * распаковав только содержащий ее блок.
+ */
+bool writeStudentsToArchive(FILE *archive, StudentArray students)
+{
+	unsigned char header[ARCHIVE_HEADER_SIZE] = { 0 };
+	if (fwrite(header, 1, sizeof(header), archive) != sizeof(header))
+	{
+		return false;
+	}
+	
+	uint64_t blockCount = (students.size + ARCHIVE_BLOCK_SIZE - 1) /
+	                      ARCHIVE_BLOCK_SIZE;
+	ByteBuffer index = { NULL, 0, 0 };
+	ByteBuffer block = { NULL, 0, 0 };
+	uint64_t offset = ARCHIVE_HEADER_SIZE;
+	for (size_t first = 0; first < students.size; first += ARCHIVE_BLOCK_SIZE)
+	{
+		size_t count = students.size - first;
+		if (count > ARCHIVE_BLOCK_SIZE)
+		{
+			count = ARCHIVE_BLOCK_SIZE;
+		}
+		block.size = 0;
+		encodeArchiveBlock(&block, students.data + first, count);
+		fwrite(block.data, 1, block.size, archive);
+		putUint64(&index, offset);
+		offset += block.size;
+	}
+	fwrite(index.data, 1, index.size, archive);
+	free(block.data);
+	free(index.data);
+	
+	memcpy(header, ARCHIVE_SIGNATURE, 4);
+	storeUint32(header + 4, ARCHIVE_BLOCK_SIZE);
+	storeUint64(header + 8, students.size);
+	storeUint64(header + 16, blockCount);
+	storeUint64(header + 24, offset);
+	fseek(archive, 0, SEEK_SET);
+	fwrite(header, 1, sizeof(header), archive);
+	fflush(archive);
+	
+	return !ferror(archive);
+}
+
+/*
+ * Проверяет заголовок по размеру файла: индекс блоков должен целиком
+ * помещаться в файл, поэтому число блоков, а с ним и число записей,
+ * ограничено размером архива.
+ */
+bool readArchiveHeader(FILE *archive, ArchiveHeader *header)
+{
+	uint64_t fileSize = getFileSize(archive);
+	unsigned char bytes[ARCHIVE_HEADER_SIZE];
+	if (fread(bytes, 1, sizeof(bytes), archive) != sizeof(bytes) ||
+	    memcmp(bytes, ARCHIVE_SIGNATURE, 4) != 0)
+	{
+		return false;
+	}
+	header->blockSize = loadUint32(bytes + 4);
+	header->studentCount = loadUint64(bytes + 8);
+	header->blockCount = loadUint64(bytes + 16);
+	header->indexOffset = loadUint64(bytes + 24);
+	
+	return header->blockSize != 0 &&
+	       header->blockCount == header->studentCount / header->blockSize +
+	                             (header->studentCount % header->blockSize != 0) &&
+	       header->indexOffset >= ARCHIVE_HEADER_SIZE &&
+	       header->indexOffset <= fileSize &&
+	       header->blockCount <= (fileSize - header->indexOffset) / 8;
+}
+
+/*
+ * Блок должен лежать между заголовком и индексом.
+ */
+bool isArchiveBlockValid(ArchiveHeader header, uint64_t begin, uint64_t end)
+{
+	return ARCHIVE_HEADER_SIZE <= begin && begin <= end &&
+	       end <= header.indexOffset;
+}
+
+size_t getArchiveBlockLength(ArchiveHeader header, uint64_t blockIndex)
+{
+	uint64_t first = blockIndex * header.blockSize;
+	uint64_t rest = header.studentCount - first;
+	return (size_t)((rest < header.blockSize) ? rest : header.blockSize);
+}
+
+bool readArchiveBlock(FILE *archive, uint64_t begin, uint64_t end,
+                      ByteBuffer *block)
+{
+	if (begin > end || !seekFile(archive, begin))
+	{
+		return false;
+	}
+	block->size = 0;
+	if (end - begin > SIZE_MAX)
+	{
+		return false;
+	}
+	size_t length = (size_t)(end - begin);
+	if (length > block->capacity)
+	{
+		unsigned char *data = (unsigned char *)realloc(block->data, length);
+		if (data == NULL)
+		{
+			return false;
+		}
+		block->data = data;
+		block->capacity = length;
+	}
+	block->size = fread(block->data, 1, length, archive);
+	return block->size == length;
+}
+
+bool getStudentsFromArchive(FILE *archive, StudentArray *students)
+{
+	students->data = NULL;
+	students->size = 0;
+	
+	ArchiveHeader header;
+	if (!readArchiveHeader(archive, &header))
+	{
+		return false;
+	}
+	
+	ByteBuffer index = { NULL, 0, 0 };
+	if (!readArchiveBlock(archive, header.indexOffset,
+	                      header.indexOffset + 8 * header.blockCount, &index))
+	{
+		free(index.data);
+		return false;
+	}
+	
+	if (header.studentCount > SIZE_MAX / sizeof(Student))
+	{
+		free(index.data);
+		return false;
+	}
+	if (header.studentCount != 0)
+	{
+		students->data = (Student *)malloc((size_t)header.studentCount *
+		                                   sizeof(Student));
+		if (students->data == NULL)
+		{
+			free(index.data);
+			return false;
+		}
+	}
+	
+	ByteBuffer block = { NULL, 0, 0 };
+	bool success = true;
+	for (uint64_t i = 0; success && i < header.blockCount; i++)
+	{
+		uint64_t begin = loadUint64(index.data + 8 * i);
+		uint64_t end = (i + 1 < header.blockCount)
+		               ? loadUint64(index.data + 8 * (i + 1))
+		               : header.indexOffset;
+		size_t count = getArchiveBlockLength(header, i);
+		success = isArchiveBlockValid(header, begin, end) &&
+		          readArchiveBlock(archive, begin, end, &block);
+		if (success)
+		{
+			ByteReader reader = { block.data, block.size, 0, false };
+			success = decodeArchiveBlock(&reader,
+			                             students->data + i * header.blockSize,
+			                             count);
+		}
+	}
+	free(block.data);
+	free(index.data);
+	
+	if (!success)
+	{
+		free(students->data);
+		students->data = NULL;
+		return false;
+	}
+	students->size = (size_t)header.studentCount;
+	return true;
+}
+
+bool getStudentFromArchive(FILE *archive, uint64_t studentIndex,
+                           Student *student)
+{
+	ArchiveHeader header;
+	if (!readArchiveHeader(archive, &header) ||
+	    studentIndex >= header.studentCount)
+	{
+		return false;
+	}
+	
+	uint64_t blockIndex = studentIndex / header.blockSize;
+	unsigned char offsets[16];
+	size_t offsetsLength = (blockIndex + 1 < header.blockCount) ? 16 : 8;
+	if (!seekFile(archive, header.indexOffset + 8 * blockIndex) ||
+	    fread(offsets, 1, offsetsLength, archive) != offsetsLength)
+	{
+		return false;
+	}
+	uint64_t begin = loadUint64(offsets);
+	uint64_t end = (offsetsLength == 16) ? loadUint64(offsets + 8)
+	                                     : header.indexOffset;
+	
+	ByteBuffer block = { NULL, 0, 0 };
+	size_t count = getArchiveBlockLength(header, blockIndex);
+	Student *blockStudents = (count <= SIZE_MAX / sizeof(Student))
+	                         ? (Student *)malloc(count * sizeof(Student))
+	                         : NULL;
+	bool success = blockStudents != NULL &&
+	               isArchiveBlockValid(header, begin, end) &&
+	               readArchiveBlock(archive, begin, end, &block);
+	if (success)
+	{
+		ByteReader reader = { block.data, block.size, 0, false };
+		success = decodeArchiveBlock(&reader, blockStudents, count);
+	}
+	if (success)
+	{
+		*student = blockStudents[studentIndex % header.blockSize];
+	}
+	free(blockStudents);
+	free(block.data);
+	
+	return success;
+}
+
+void printThroughput(const char *title, uint64_t bytes, size_t records,
+                     double seconds)
+{
+	if (seconds <= 0)
+	{
+		printf("%s: слишком быстро для измерения\n", title);
+		return;
+	}
+	printf("%s: %.3lf с, %.2lf МБ/с, %.0lf записей/с\n", title, seconds,
+	       (double)bytes / (1 << 20) / seconds, (double)records / seconds);
+}
+
+void compressNotes(const char *fileName, const char *archiveName)
+{
+	FILE *notes = fopen(fileName, "r");
+	if (notes == NULL)
+	{
+		puts("Не удалось открыть файл записей!\n");
+		return;
+	}
+	uint64_t notesSize = getFileSize(notes);
+	double start = getMonotonicTime();
+	StudentArray students = getStudents(notes);
+	double textSeconds = getMonotonicTime() - start;
+	fclose(notes);
+	
+	FILE *archive = fopen(archiveName, "w+b");
+	if (archive == NULL || !writeStudentsToArchive(archive, students))
+	{
+		if (archive != NULL)
+		{
+			fclose(archive);
+		}
+		free(students.data);
+		puts("Не удалось записать архив!\n");
+		return;
+	}
+	uint64_t archiveSize = getFileSize(archive);
+	
+	StudentArray decoded;
+	start = getMonotonicTime();
+	bool decodedSuccessfully = getStudentsFromArchive(archive, &decoded);
+	double archiveSeconds = getMonotonicTime() - start;
+	fclose(archive);
+	
+	printf("Записей: %zu\n", students.size);
+	printf("Размер файла записей: %" PRIu64 " байт\n", notesSize);
+	printf("Размер архива: %" PRIu64 " байт\n", archiveSize);
+	if (archiveSize > 0)
+	{
+		printf("Степень сжатия: %.2lf\n", (double)notesSize / archiveSize);
+	}
+	printThroughput("Чтение файла записей", notesSize, students.size,
+	                textSeconds);
+	if (decodedSuccessfully)
+	{
+		printThroughput("Распаковка архива", notesSize, decoded.size,
+		                archiveSeconds);
+	}
+	puts("Архив создан.\n");
+	
+	free(decoded.data);
+	free(students.data);
+}
+
+uint64_t nextRandom(uint64_t *state)
+{
+	uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+double nextRandomUnit(uint64_t *state)
+{
+	return (double)(nextRandom(state) >> 11) / 9007199254740992.0;
+}
+
+double nextRandomNormal(uint64_t *state)
+{
+	double sum = 0;
+	for (int i = 0; i < 12; i++)
+	{
+		sum += nextRandomUnit(state);
+	}
+	return sum - 6;
+}
+
+int clampGrade(double grade)
+{
+	if (grade < 0)
+	{
+		return 0;
+	}
+	if (grade > 10)
+	{
+		return 10;
+	}
+	return (int)(grade + 0.5);
+}
+
+const char *const GENERATED_SURNAMES[] = {
+	"Иванов", "Смирнов", "Кузнецов", "Попов", "Васильев", "Петров",
+	"Соколов", "Михайлов", "Новиков", "Фёдоров", "Морозов", "Волков",
+	"Алексеев", "Лебедев", "Семёнов", "Егоров", "Павлов", "Козлов",
+	"Степанов", "Николаев", "Орлов", "Андреев", "Макаров", "Никитин",
+	"Захаров", "Зайцев", "Соловьёв", "Борисов", "Яковлев", "Григорьев",
+	"Романов", "Воробьёв", "Сергеев", "Ковалёв", "Жуков", "Белов",
+	"Тарасов", "Киселёв", "Ильин", "Гусев", "Титов", "Кравченко",
+	"Шевчук", "Коваленко", "Бондаренко", "Ткаченко", "Мельник", "Новик",
+	"Климович", "Савицкий", "Якубович", "Лукашевич", "Островский",
+	"Гончаров", "Карпович", "Жданович", "Рыбаков", "Дубровский"
+};
+
+bool endsWith(const char *s, const char *suffix)
+{
+	size_t length = strlen(s);
+	size_t suffixLength = strlen(suffix);
+	return length >= suffixLength &&
+	       strcmp(s + length - suffixLength, suffix) == 0;
+}
+
+void generateSurname(uint64_t *state, char *surname)
+{
+	size_t count = sizeof(GENERATED_SURNAMES) / sizeof(GENERATED_SURNAMES[0]);
+	double u = nextRandomUnit(state);
+	const char *base = GENERATED_SURNAMES[(size_t)(u * u * (double)count)];
+	strcpy(surname, base);
+	
+	if (nextRandom(state) % 2 == 0)
+	{
+		return;
+	}
+	if (endsWith(base, "ов") || endsWith(base, "ев") ||
+	    endsWith(base, "ёв") || endsWith(base, "ин"))
+	{
+		strcat(surname, "а");
+	}
+	else if (endsWith(base, "ий"))
+	{
+		strcpy(surname + strlen(surname) - strlen("ий"), "ая");
+	}
+}
+
+int generateGroup(uint64_t *state)
+{
+	int faculty = 1 + (int)(nextRandom(state) % 9);
+	int year = (int)(nextRandom(state) % 10);
+	int specialty = (int)(nextRandom(state) % 100);
+	int number = 1 + (int)(nextRandom(state) % 5);
+	return faculty * 100000 + year * 10000 + specialty * 100 + number;
+}
+
+void generateStudent(uint64_t *state, int group, Student *student)
+{
+	generateSurname(state, student->surname);
+	student->group = group;
+	
+	if (nextRandomUnit(state) < 0.02)
+	{
+		student->physicsGrade = 0;
+		student->mathsGrade = 0;
+		student->informaticsGrade = 0;
+		student->GPA = 0;
+		return;
+	}
+	
+	double ability = 6.5 + 1.6 * nextRandomNormal(state);
+	student->physicsGrade = clampGrade(ability + 1.2 * nextRandomNormal(state));
+	student->mathsGrade = clampGrade(ability + 1.2 * nextRandomNormal(state));
+	student->informaticsGrade = clampGrade(ability +
+	                                       1.2 * nextRandomNormal(state));
+	
+	double GPA = ability + 0.4 * nextRandomNormal(state);
+	GPA = (GPA < 0) ? 0 : (GPA > 10) ? 10 : GPA;
+	student->GPA = (double)(int)(GPA * 10 + 0.5) / 10;
+}
+
+/*
+ * Записи генерируются по группам из 15-30 человек, как в реальных
+ * ведомостях; распространенные фамилии встречаются чаще редких.
+ */
+void generateNotes(FILE *notes, size_t count, uint64_t seed)
+{
+	uint64_t state = seed;
+	OutputBuffer output;
+	openOutputBuffer(&output, notes);
+	Student student;
+	int group = 0;
+	size_t groupLeft = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (groupLeft == 0)
+		{
+			group = generateGroup(&state);
+			groupLeft = 15 + nextRandom(&state) % 16;
+		}
+		groupLeft--;
+		
+		generateStudent(&state, group, &student);
+		outputStudent(&output, &student);
+	}
+	closeOutputBuffer(&output);
+}
+
+void reportBenchmark(FILE *results, const char *operation, int criterion,
+                     size_t records, size_t operations, double seconds)
+{
+	printf("%-10s %2d %10zu %12.6lf с\n", operation, criterion, records,
+	       seconds);
+	fprintf(results, "{\"operation\":\"%s\",\"criterion\":%d,"
+	                 "\"records\":%zu,\"operations\":%zu,"
+	                 "\"seconds\":%.9lf,\"status\":\"ok\"}\n",
+	        operation, criterion, records, operations, seconds);
+	fflush(results);
+}
+
+void runBenchmark(FILE *results, size_t records)
+{
+	const char *notesName = "benchmark_notes.txt";
+	const char *outputName = "benchmark_output.txt";
+	
+	FILE *notes = fopen(notesName, "w");
+	if (notes == NULL)
+	{
+		puts("Не удалось создать файл записей для замеров!\n");
+		return;
+	}
+	double start = getMonotonicTime();
+	generateNotes(notes, records, records);
+	fclose(notes);
+	reportBenchmark(results, "generate", 0, records, 1,
+	                getMonotonicTime() - start);
+	
+	notes = fopen(notesName, "r");
+	if (notes == NULL)
+	{
+		puts("Не удалось открыть файл записей для замеров!\n");
+		remove(notesName);
+		return;
+	}
+	start = getMonotonicTime();
+	StudentArray students = getStudents(notes);
+	reportBenchmark(results, "load", 0, records, 1,
+	                getMonotonicTime() - start);
+	fclose(notes);
+	
+	FILE *output = fopen(outputName, "w");
+	if (output == NULL)
+	{
+		puts("Не удалось создать файл для замеров записи, замеры записи "
+		     "пропущены.");
+	}
+	else
+	{
+		start = getMonotonicTime();
+		writeStudentsToFile(output, students);
+		fclose(output);
+		reportBenchmark(results, "save", 0, records, 1,
+		                getMonotonicTime() - start);
+		
+		output = fopen(outputName, "w");
+		start = getMonotonicTime();
+		writeIndividualTask(output, students);
+		fclose(output);
+		reportBenchmark(results, "filter", 0, records, 1,
+		                getMonotonicTime() - start);
+	}
+	
+	StudentArray sorted;
+	sorted.size = students.size;
+	sorted.data = (Student *)malloc((students.size + 1) * sizeof(Student));
+	if (sorted.data == NULL)
+	{
+		puts("Недостаточно памяти для копии записей, замеры сортировки "
+		     "пропущены.");
+	}
+	for (int criterion = 1;
+	     sorted.data != NULL && criterion <= STUDENT_SORT_CRITERION_COUNT;
+	     criterion++)
+	{
+		memcpy(sorted.data, students.data, students.size * sizeof(Student));
+		start = getMonotonicTime();
+		if (!sortStudents(&sorted, criterion))
+		{
+			puts("Недостаточно памяти для сортировки, замер пропущен.");
+			continue;
+		}
+		reportBenchmark(results, "sort", criterion, records, 1,
+		                getMonotonicTime() - start);
+	}
+	free(sorted.data);
+	
+	char surnames[BENCHMARK_LOOKUP_COUNT][STRING_BUFFER_MAX_SIZE];
+	size_t lookupCount = (students.size < BENCHMARK_LOOKUP_COUNT)
+	                     ? students.size : BENCHMARK_LOOKUP_COUNT;
+	uint64_t state = records;
+	for (size_t k = 0; k < lookupCount; k++)
+	{
+		strcpy(surnames[k],
+		       students.data[nextRandom(&state) % students.size].surname);
+	}
+	
+	start = getMonotonicTime();
+	for (size_t k = 0; k < lookupCount; k++)
+	{
+		size_t i = findStudent(students, surnames[k]);
+		if (i != students.size)
+		{
+			students.data[i].mathsGrade = 10;
+		}
+	}
+	reportBenchmark(results, "edit", 0, records, lookupCount,
+	                getMonotonicTime() - start);
+	
+	start = getMonotonicTime();
+	for (size_t k = 0; k < lookupCount; k++)
+	{
+		size_t i = findStudent(students, surnames[k]);
+		if (i != students.size)
+		{
+			removeStudent(&students, i);
+		}
+	}
+	reportBenchmark(results, "delete", 0, records, lookupCount,
+	                getMonotonicTime() - start);
+	
+	free(students.data);
+	remove(notesName);
+	remove(outputName);
+}
+
+void benchmarkNotes(const char *resultsName, size_t maxRecords)
+{
+	FILE *results = fopen(resultsName, "w");
+	if (results == NULL)
+	{
+		puts("Не удалось открыть файл результатов!\n");
+		return;
+	}
+	
+	const size_t sizes[] = { 1000, 100000, 1000000, 10000000 };
+	puts("Операция  Кр.    Записей        Время");
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	{
+		if (sizes[i] <= maxRecords)
+		{
+			/*
+			 * Записи, их копия для сортировки и отсортированный массив
+			 * должны поместиться в память одновременно.
+			 */
+			void *probe = (sizes[i] <= SIZE_MAX / 3 / sizeof(Student))
+			              ? malloc(3 * sizes[i] * sizeof(Student)) : NULL;
+			if (probe == NULL)
+			{
+				printf("Недостаточно памяти для %zu записей, замеры "
+				       "пропущены.\n", sizes[i]);
+				continue;
+			}
+			free(probe);
+			printf("(около %zu МБ памяти)\n",
+			       3 * sizes[i] * sizeof(Student) >> 20);
+			runBenchmark(results, sizes[i]);
+		}
+	}
+	fclose(results);
+	
+	puts("Результаты замеров записаны в файл.\n");
+}
+
+#define MERGE_FIELD_STRING(destination, source) ((void)0)
+#define MERGE_FIELD_INT(destination, source) \
+	destination = ((source) > (destination)) ? (source) : (destination)
+#define MERGE_FIELD_REAL(destination, source) \
+	destination = ((source) > (destination)) ? (source) : (destination)
+
+#define MERGE_STUDENT_FIELD(name, type, ...) \
+	MERGE_FIELD_##type(destination->name, source->name);
+#define COMPARE_STUDENT_FIELD(name, ...) \
+	if (compareStudentsBy_##name(s1, s2) != 0) \
+	{ \
+		return false; \
+	}
+
+void mergeStudentMaximum(Student *destination, const Student *source)
+{
+	STUDENT_FIELDS(MERGE_STUDENT_FIELD)
+}
+
+bool areStudentsEqual(const Student *s1, const Student *s2)
+{
+	STUDENT_FIELDS(COMPARE_STUDENT_FIELD)
+	return true;
+}
+
+uint64_t hashStudentKey(const Student *student)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (const unsigned char *c = (const unsigned char *)student->surname;
+	     *c != '\0'; c++)
+	{
+		hash = (hash ^ *c) * 1099511628211ULL;
+	}
+	hash = (hash ^ (uint32_t)student->group) * 1099511628211ULL;
+	return hash ^ (hash >> 29);
+}
+
+bool haveSameKey(const Student *s1, const Student *s2)
+{
+	return s1->group == s2->group && strcmp(s1->surname, s2->surname) == 0;
+}
+
+size_t findStudentKeySlot(const StudentKeyTable *table, StudentArray students,
+                          const Student *key)
+{
+	size_t mask = table->capacity - 1;
+	size_t slot = (size_t)hashStudentKey(key) & mask;
+	while (table->slots[slot].first != NO_STUDENT &&
+	       !haveSameKey(&students.data[table->slots[slot].first], key))
+	{
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+/*
+ * Открытая адресация по ключу (фамилия, группа). Записи с одинаковым
+ * ключом связаны в список next в порядке следования в файле; pending -
+ * первая из них, еще не сопоставленная с записью другого файла.
+ */
+/*
+ * Возвращает false, если памяти под таблицу не хватило; таблицу после
+ * этого все равно нужно удалить deleteStudentKeyTable.
+ */
+bool buildStudentKeyTable(StudentKeyTable *table, StudentArray students)
+{
+	table->capacity = 16;
+	while (table->capacity < 2 * students.size)
+	{
+		table->capacity *= 2;
+	}
+	table->slots = (StudentKeySlot *)malloc(table->capacity *
+	                                        sizeof(StudentKeySlot));
+	table->next = (size_t *)malloc((students.size + 1) * sizeof(size_t));
+	if (table->slots == NULL || table->next == NULL)
+	{
+		return false;
+	}
+	for (size_t slot = 0; slot < table->capacity; slot++)
+	{
+		table->slots[slot].first = NO_STUDENT;
+		table->slots[slot].pending = NO_STUDENT;
+	}
+	
+	for (size_t i = students.size; i-- > 0;)
+	{
+		StudentKeySlot *slot = &table->slots[findStudentKeySlot(
+			table, students, &students.data[i])];
+		table->next[i] = slot->first;
+		slot->first = i;
+		slot->pending = i;
+	}
+	return true;
+}
+
+void deleteStudentKeyTable(StudentKeyTable *table)
+{
+	free(table->slots);
+	table->slots = NULL;
+	free(table->next);
+	table->next = NULL;
+	table->capacity = 0;
+}
+
+void copyFileContents(FILE *source, FILE *destination)
+{
+	char buffer[1 << 14];
+	size_t count;
+	rewind(source);
+	while ((count = fread(buffer, 1, sizeof(buffer), source)) != 0)
+	{
+		fwrite(buffer, 1, count, destination);
+	}
+}
+
+/*
+ * Основной файл загружается в память и хешируется по ключу, второй файл
+ * читается потоково, поэтому сравнение выполняется за один линейный
+ * проход. Записи с одинаковым ключом сопоставляются по порядку. Память
+ * ограничивает только размер основного файла: около sizeof(Student) байт
+ * на запись плюс таблица ключей, размер обновленного файла не важен.
+ * Возвращает false, если памяти не хватило или не удалось создать
+ * временный файл; отчет и результат при этом не записываются.
+ */
+bool diffNotes(FILE *master, FILE *update, FILE *report, FILE *merged,
+               MergePolicy policy, bool dropRemoved, NotesDiffSummary *summary)
+{
+	summary->added = 0;
+	summary->removed = 0;
+	summary->changed = 0;
+	summary->unchanged = 0;
+	
+	StudentArray masterStudents = getStudents(master);
+	StudentKeyTable table;
+	bool built = buildStudentKeyTable(&table, masterStudents);
+	bool *matched = (bool *)calloc(masterStudents.size + 1, sizeof(bool));
+	FILE *added = tmpfile();
+	if (!built || matched == NULL || added == NULL)
+	{
+		if (added != NULL)
+		{
+			fclose(added);
+		}
+		free(matched);
+		deleteStudentKeyTable(&table);
+		free(masterStudents.data);
+		return false;
+	}
+	OutputBuffer addedOutput;
+	openOutputBuffer(&addedOutput, added);
+	OutputBuffer reportOutput;
+	openOutputBuffer(&reportOutput, report);
+	
+	StudentReader reader;
+	openStudentReader(&reader, update);
+	NotesOrder order;
+	readNotesOrder(&reader, &order);
+	Student student;
+	while (readStudent(&reader, &student))
+	{
+		StudentKeySlot *slot = &table.slots[findStudentKeySlot(
+			&table, masterStudents, &student)];
+		if (slot->pending == NO_STUDENT)
+		{
+			summary->added++;
+			outputString(&reportOutput, "Добавлено:\n");
+			outputStudentView(&reportOutput, &student);
+			outputStudent(&addedOutput, &student);
+			continue;
+		}
+		
+		size_t i = slot->pending;
+		slot->pending = table.next[i];
+		matched[i] = true;
+		if (areStudentsEqual(&masterStudents.data[i], &student))
+		{
+			summary->unchanged++;
+			continue;
+		}
+		
+		summary->changed++;
+		outputString(&reportOutput, "Изменено (было):\n");
+		outputStudentView(&reportOutput, &masterStudents.data[i]);
+		outputString(&reportOutput, "Изменено (стало):\n");
+		outputStudentView(&reportOutput, &student);
+		if (policy == MERGE_TAKE_UPDATE)
+		{
+			copyStudent(&masterStudents.data[i], &student);
+		}
+		else if (policy == MERGE_TAKE_MAXIMUM)
+		{
+			mergeStudentMaximum(&masterStudents.data[i], &student);
+		}
+	}
+	closeStudentReader(&reader);
+	
+	OutputBuffer mergedOutput;
+	openOutputBuffer(&mergedOutput, merged);
+	for (size_t i = 0; i < masterStudents.size; i++)
+	{
+		if (!matched[i])
+		{
+			summary->removed++;
+			outputString(&reportOutput, "Удалено:\n");
+			outputStudentView(&reportOutput, &masterStudents.data[i]);
+		}
+		if (matched[i] || !dropRemoved)
+		{
+			outputStudent(&mergedOutput, &masterStudents.data[i]);
+		}
+	}
+	closeOutputBuffer(&mergedOutput);
+	closeOutputBuffer(&reportOutput);
+	closeOutputBuffer(&addedOutput);
+	copyFileContents(added, merged);
+	fclose(added);
+	
+	free(matched);
+	deleteStudentKeyTable(&table);
+	free(masterStudents.data);
+	
+	return true;
+}
+
+void mergeNotes(const char *masterName, const char *updateName,
+                const char *reportName, const char *mergedName,
+                MergePolicy policy, bool dropRemoved)
+{
+	FILE *master = fopen(masterName, "r");
+	FILE *update = fopen(updateName, "r");
+	if (master == NULL || update == NULL)
+	{
+		puts("Не удалось открыть файлы записей!\n");
+	}
+	else
+	{
+		FILE *report = fopen(reportName, "w");
+		FILE *merged = fopen(mergedName, "w");
+		if (report == NULL || merged == NULL)
+		{
+			puts("Не удалось открыть файлы отчета и результата!\n");
+		}
+		else
+		{
+			NotesDiffSummary summary;
+			if (!diffNotes(master, update, report, merged, policy,
+			               dropRemoved, &summary))
+			{
+				puts("Не удалось сравнить файлы: недостаточно памяти для "
+				     "основного файла или не удалось создать временный "
+				     "файл!\n");
+			}
+			else
+			{
+				printf("Добавлено записей: %zu\n", summary.added);
+				printf("Удалено записей: %zu\n", summary.removed);
+				printf("Изменено записей: %zu\n", summary.changed);
+				printf("Без изменений: %zu\n", summary.unchanged);
+				puts("Отчет и объединенный файл записаны.\n");
+			}
+		}
+		if (merged != NULL)
+		{
+			fclose(merged);
+		}
+		if (report != NULL)
+		{
+			fclose(report);
+		}
+	}
+	if (master != NULL)
+	{
+		fclose(master);
+	}
+	if (update != NULL)
+	{
+		fclose(update);
+	}
+}
+
+void addNotesIndexOffset(NotesIndex *index, uint64_t offset)
+{
+	index->offsets = (uint64_t *)realloc(index->offsets,
+	                                     ++index->count * sizeof(uint64_t));
+	index->offsets[index->count - 1] = offset;
+}
+
+/*
+ * Разреженный индекс: смещение в файле каждой NOTES_INDEX_STRIDE-й
+ * корректной записи. Записи выделяются тем же разбором, что и при чтении
+ * файла (readStudent), поэтому пустые строки, записи с ошибками и запись
+ * без завершающего перевода строки учитываются одинаково; сообщения об
+ * ошибках при построении индекса не выводятся. Смещение записи - позиция
+ * читателя перед ее чтением: readStudent с этой позиции вернет именно ее.
+ */
+void buildNotesIndex(FILE *notes, NotesIndex *index)
+{
+	index->offsets = NULL;
+	index->count = 0;
+	index->studentCount = 0;
+	
+	StudentReader reader;
+	openStudentReader(&reader, notes);
+	reader.quiet = true;
+	NotesOrder order;
+	readNotesOrder(&reader, &order);
+	addNotesIndexOffset(index, getStudentReaderOffset(&reader));
+	
+	Student student;
+	while (readStudent(&reader, &student))
+	{
+		if (++index->studentCount % NOTES_INDEX_STRIDE == 0)
+		{
+			addNotesIndexOffset(index, getStudentReaderOffset(&reader));
+		}
+	}
+	closeStudentReader(&reader);
+}
+
+void deleteNotesIndex(NotesIndex *index)
+{
+	free(index->offsets);
+	index->offsets = NULL;
+	index->count = 0;
+	index->studentCount = 0;
+}
+
+/*
+ * Пропускает count корректных записей тем же разбором, что и readStudent
+ * (им же строится индекс); об ошибках в пропущенных записях не сообщается.
+ */
+bool skipStudents(StudentReader *reader, size_t count)
+{
+	bool quiet = reader->quiet;
+	reader->quiet = true;
+	Student student;
+	size_t skipped = 0;
+	while (skipped < count && readStudent(reader, &student))
+	{
+		skipped++;
+	}
+	reader->quiet = quiet;
+	return skipped == count;
+}
+
+size_t readNotesPage(FILE *notes, const NotesIndex *index, size_t first,
+                     Student *page, size_t pageSize)
+{
+	StudentReader reader;
+	openStudentReader(&reader, notes);
+	size_t count = 0;
+	if (seekStudentReader(&reader,
+	                      index->offsets[first / NOTES_INDEX_STRIDE]) &&
+	    skipStudents(&reader, first % NOTES_INDEX_STRIDE))
+	{
+		while (count < pageSize && readStudent(&reader, &page[count]))
+		{
+			count++;
+		}
+	}
+	closeStudentReader(&reader);
+	return count;
+}
+
+size_t findNotesSurname(FILE *notes, size_t studentCount, const char *surname)
+{
+	StudentReader reader;
+	openStudentReader(&reader, notes);
+	reader.quiet = true;
+	size_t number = 0;
+	bool found = false;
+	if (seekStudentReader(&reader, 0))
+	{
+		NotesOrder order;
+		readNotesOrder(&reader, &order);
+		Student student;
+		while (!found && number < studentCount &&
+		       readStudent(&reader, &student))
+		{
+			found = strcmp(student.surname, surname) == 0;
+			number += !found;
+		}
+	}
+	closeStudentReader(&reader);
+	return found ? number : studentCount;
+}
+
+void viewNotesPaged(const char *fileName)
+{
+	FILE *notes = fopen(fileName, "rb");
+	if (notes == NULL)
+	{
+		puts("Не удалось открыть файл записей!\n");
+		return;
+	}
+	NotesIndex index;
+	buildNotesIndex(notes, &index);
+	if (index.studentCount == 0)
+	{
+		puts("Файл записей пуст.\n");
+		deleteNotesIndex(&index);
+		fclose(notes);
+		return;
+	}
+	
+	Student *page = (Student *)malloc(NOTES_PAGE_SIZE * sizeof(Student));
+	size_t first = 0;
+	int option = 1;
+	while (1 <= option && option <= 4)
+	{
+		StudentArray students;
+		students.data = page;
+		students.size = readNotesPage(notes, &index, first, page,
+		                              NOTES_PAGE_SIZE);
+		viewFile(students);
+		printf("Записи %zu-%zu из %zu.\n", first + 1, first + students.size,
+		       index.studentCount);
+		puts("1. Следующая страница.\n"
+		     "2. Предыдущая страница.\n"
+		     "3. Перейти к записи по номеру.\n"
+		     "4. Перейти к студенту по фамилии.\n"
+		     "Любое другое число - выход из просмотра.");
+		scanf("%d", &option);
+		
+		size_t number = 0;
+		char surname[STRING_BUFFER_MAX_SIZE];
+		switch (option)
+		{
+			case 1:
+				if (first + NOTES_PAGE_SIZE < index.studentCount)
+				{
+					first += NOTES_PAGE_SIZE;
+				}
+				break;
+			case 2:
+				first = (first > NOTES_PAGE_SIZE) ? first - NOTES_PAGE_SIZE : 0;
+				break;
+			case 3:
+				puts("Введите номер записи:");
+				scanf("%zu", &number);
+				if (1 <= number && number <= index.studentCount)
+				{
+					first = number - 1;
+				}
+				else
+				{
+					puts("Нет такой записи!\n");
+				}
+				break;
+			case 4:
+				puts("Введите фамилию студента:");
+				scanString(surname);
+				number = findNotesSurname(notes, index.studentCount, surname);
+				if (number != index.studentCount)
+				{
+					first = number;
+				}
+				else
+				{
+					puts("Нет такого студента!\n");
+				}
+				break;
+			default:
+				puts("Выход из режима просмотра...\n");
+		}
+	}
+	
+	free(page);
+	deleteNotesIndex(&index);
+	fclose(notes);
+}
+
+size_t resolveDuplicates(StudentArray students, const StudentKeyTable *table,
+                         size_t first, DeduplicationPolicy policy,
+                         OutputBuffer *report)
+{
+	size_t count = 0;
+	size_t chosen = first;
+	Student merged;
+	copyStudent(&merged, &students.data[first]);
+	for (size_t i = first; i != NO_STUDENT; i = table->next[i])
+	{
+		count++;
+		if (policy == DEDUPLICATE_LATEST ||
+		    (policy == DEDUPLICATE_HIGHEST_GPA &&
+		     students.data[i].GPA > students.data[chosen].GPA))
+		{
+			chosen = i;
+		}
+		mergeStudentMaximum(&merged, &students.data[i]);
+	}
+	if (count == 1)
+	{
+		return 0;
+	}
+	
+	outputString(report, "Дубликаты (");
+	outputInt(report, (int)count);
+	outputString(report, " записей):\n");
+	for (size_t i = first; i != NO_STUDENT; i = table->next[i])
+	{
+		outputStudentView(report, &students.data[i]);
+	}
+	if (policy == DEDUPLICATE_MAXIMUM)
+	{
+		copyStudent(&students.data[first], &merged);
+	}
+	else if (chosen != first)
+	{
+		copyStudent(&students.data[first], &students.data[chosen]);
+	}
+	outputString(report, "Оставлена запись:\n");
+	outputStudentView(report, &students.data[first]);
+	
+	return count - 1;
+}
+
+/*
+ * Оставляет по одной записи на ключ (фамилия, группа) на месте первого
+ * вхождения ключа, сохраняя порядок остальных записей. Если памяти под
+ * таблицу ключей не хватило, возвращает false, не меняя записи и отчет.
+ */
+bool deduplicateStudents(StudentArray *students, DeduplicationPolicy policy,
+                         OutputBuffer *report, size_t *removed)
+{
+	StudentKeyTable table;
+	bool built = buildStudentKeyTable(&table, *students);
+	bool *keep = (bool *)malloc((students->size + 1) * sizeof(bool));
+	if (!built || keep == NULL)
+	{
+		free(keep);
+		deleteStudentKeyTable(&table);
+		return false;
+	}
+	
+	*removed = 0;
+	for (size_t i = 0; i < students->size; i++)
+	{
+		size_t slot = findStudentKeySlot(&table, *students,
+		                                 &students->data[i]);
+		keep[i] = table.slots[slot].first == i;
+		if (keep[i])
+		{
+			*removed += resolveDuplicates(*students, &table, i, policy,
+			                              report);
+		}
+	}
+	
+	size_t size = 0;
+	for (size_t i = 0; i < students->size; i++)
+	{
+		if (keep[i])
+		{
+			if (size != i)
+			{
+				copyStudent(&students->data[size], &students->data[i]);
+			}
+			size++;
+		}
+	}
+	students->size = size;
+	
+	free(keep);
+	deleteStudentKeyTable(&table);
+	return true;
+}
+
+bool deduplicateStream(FILE *notes, FILE *output, DeduplicationPolicy policy,
+                       OutputBuffer *report, size_t *removed)
+{
+	StudentArray students = getStudents(notes);
+	bool success = deduplicateStudents(&students, policy, report, removed);
+	if (success)
+	{
+		writeStudentsToFile(output, students);
+	}
+	free(students.data);
+	return success;
+}
+
+void closePartitions(FILE **partitions, size_t count)
+{
+	for (size_t p = 0; p < count; p++)
+	{
+		fclose(partitions[p]);
+	}
+}
+
+/*
+ * Для больших файлов записи раскладываются по временным файлам по хешу
+ * ключа, так что все дубликаты попадают в один раздел, а каждый раздел
+ * помещается в память. В разделы сначала идут уже загруженные записи
+ * (loaded, память под них освобождается) и запись pending, затем
+ * остаток файла из reader. Порядок записей в этом режиме сохраняется
+ * только внутри раздела. Возвращает false, если не удалось создать
+ * временный файл или обработать раздел.
+ */
+bool deduplicatePartitioned(StudentReader *reader, StudentArray *loaded,
+                            const Student *pending, size_t partitionCount,
+                            FILE *output, DeduplicationPolicy policy,
+                            OutputBuffer *report, size_t *removed)
+{
+	FILE **partitions = (FILE **)malloc(partitionCount * sizeof(FILE *));
+	OutputBuffer *outputs = (OutputBuffer *)malloc(partitionCount *
+	                                               sizeof(OutputBuffer));
+	if (partitions == NULL || outputs == NULL)
+	{
+		free(outputs);
+		free(partitions);
+		return false;
+	}
+	for (size_t p = 0; p < partitionCount; p++)
+	{
+		partitions[p] = tmpfile();
+		if (partitions[p] == NULL)
+		{
+			for (size_t q = 0; q < p; q++)
+			{
+				closeOutputBuffer(&outputs[q]);
+			}
+			closePartitions(partitions, p);
+			free(outputs);
+			free(partitions);
+			return false;
+		}
+		openOutputBuffer(&outputs[p], partitions[p]);
+	}
+	
+	for (size_t i = 0; i < loaded->size; i++)
+	{
+		Student *student = &loaded->data[i];
+		size_t p = (size_t)((hashStudentKey(student) >> 32) % partitionCount);
+		outputStudent(&outputs[p], student);
+	}
+	free(loaded->data);
+	loaded->data = NULL;
+	loaded->size = 0;
+	if (pending != NULL)
+	{
+		size_t p = (size_t)((hashStudentKey(pending) >> 32) % partitionCount);
+		outputStudent(&outputs[p], pending);
+	}
+	Student student;
+	while (readStudent(reader, &student))
+	{
+		size_t p = (size_t)((hashStudentKey(&student) >> 32) % partitionCount);
+		outputStudent(&outputs[p], &student);
+	}
+	for (size_t p = 0; p < partitionCount; p++)
+	{
+		closeOutputBuffer(&outputs[p]);
+	}
+	
+	*removed = 0;
+	bool success = true;
+	for (size_t p = 0; p < partitionCount && success; p++)
+	{
+		size_t partitionRemoved = 0;
+		rewind(partitions[p]);
+		success = deduplicateStream(partitions[p], output, policy, report,
+		                            &partitionRemoved);
+		*removed += partitionRemoved;
+	}
+	
+	closePartitions(partitions, partitionCount);
+	free(outputs);
+	free(partitions);
+	return success;
+}
+
+/*
+ * Файл читается один раз: записи загружаются в память, пока их объем не
+ * превысит DEDUPLICATION_MEMORY_LIMIT (или пока не кончится память), а
+ * после этого загруженные записи и остаток файла раскладываются по
+ * разделам, число которых оценивается по доле уже прочитанного файла.
+ */
+void deduplicateNotes(const char *fileName, const char *outputName,
+                      const char *reportName, DeduplicationPolicy policy)
+{
+	FILE *notes = fopen(fileName, "rb");
+	if (notes == NULL)
+	{
+		puts("Не удалось открыть файл записей!\n");
+		return;
+	}
+	FILE *output = fopen(outputName, "w");
+	FILE *reportFile = fopen(reportName, "w");
+	if (output == NULL || reportFile == NULL)
+	{
+		puts("Не удалось открыть файлы результата и отчета!\n");
+		if (output != NULL)
+		{
+			fclose(output);
+		}
+		if (reportFile != NULL)
+		{
+			fclose(reportFile);
+		}
+		fclose(notes);
+		return;
+	}
+	uint64_t fileSize = getFileSize(notes);
+	
+	StudentReader reader;
+	openStudentReader(&reader, notes);
+	NotesOrder order;
+	readNotesOrder(&reader, &order);
+	StudentArray students;
+	students.size = 0;
+	students.data = NULL;
+	size_t capacity = 0;
+	size_t limit = DEDUPLICATION_MEMORY_LIMIT / sizeof(Student);
+	Student student;
+	bool pending = false;
+	while (readStudent(&reader, &student))
+	{
+		if (students.size == limit ||
+		    !addStudent(&students, &capacity, &student))
+		{
+			pending = true;
+			break;
+		}
+	}
+	
+	OutputBuffer report;
+	openOutputBuffer(&report, reportFile);
+	size_t removed = 0;
+	bool success;
+	if (!pending &&
+	    deduplicateStudents(&students, policy, &report, &removed))
+	{
+		writeStudentsToFile(output, students);
+		success = true;
+	}
+	else
+	{
+		puts("Файл слишком велик для обработки в памяти, записи будут "
+		     "обработаны по частям.");
+		uint64_t consumed = getStudentReaderOffset(&reader);
+		size_t partitionCount = (size_t)(fileSize / (consumed + 1)) * 2 + 2;
+		success = deduplicatePartitioned(&reader, &students,
+		                                 pending ? &student : NULL,
+		                                 partitionCount, output, policy,
+		                                 &report, &removed);
+	}
+	closeStudentReader(&reader);
+	closeOutputBuffer(&report);
+	fclose(reportFile);
+	fclose(output);
+	free(students.data);
+	fclose(notes);
+	
+	if (!success)
+	{
+		puts("Не удалось удалить дубликаты: не удалось создать временный "
+		     "файл или недостаточно памяти!\n");
+		return;
+	}
+	printf("Удалено дубликатов: %zu\n", removed);
+	puts("Отчет и файл без дубликатов записаны.\n");
+}
+
+#define HASH_FIELD_STRING(hash, field) \
+	hash = hashBytes(hash, field, strlen(field) + 1)
+#define HASH_FIELD_INT(hash, field) \
+	hash = hashValue(hash, (uint32_t)(field))
+#define HASH_FIELD_REAL(hash, field) \
+	hash = hashReal(hash, field)
+
+#define HASH_STUDENT_FIELD(name, type, ...) \
+	HASH_FIELD_##type(hash, student->name);
+
+uint64_t hashBytes(uint64_t hash, const void *bytes, size_t count)
+{
+	const unsigned char *c = (const unsigned char *)bytes;
+	for (size_t i = 0; i < count; i++)
+	{
+		hash = (hash ^ c[i]) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+uint64_t hashValue(uint64_t hash, uint64_t value)
+{
+	unsigned char bytes[8];
+	storeUint64(bytes, value);
+	return hashBytes(hash, bytes, sizeof(bytes));
+}
+
+uint64_t hashReal(uint64_t hash, double value)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return hashValue(hash, bits);
+}
+
+uint64_t hashStudent(const Student *student)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	STUDENT_FIELDS(HASH_STUDENT_FIELD)
+	return hash ^ (hash >> 29);
+}
+
+uint64_t hashStudents(StudentArray students)
+{
+	uint64_t hash = hashValue(14695981039346656037ULL, students.size);
+	for (size_t i = 0; i < students.size; i++)
+	{
+		hash = hashValue(hash, hashStudent(&students.data[i]));
+	}
+	return hash;
+}
+
+size_t findStudentContentSlot(const StudentContentTable *table,
+                              StudentArray students, const Student *student)
+{
+	size_t mask = table->capacity - 1;
+	size_t slot = (size_t)hashStudent(student) & mask;
+	while (table->slots[slot] != NO_STUDENT &&
+	       !areStudentsEqual(&students.data[table->slots[slot]], student))
+	{
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+void buildStudentContentTable(StudentContentTable *table,
+                              StudentArray students)
+{
+	table->capacity = 16;
+	while (table->capacity < 2 * students.size)
+	{
+		table->capacity *= 2;
+	}
+	table->slots = (size_t *)malloc(table->capacity * sizeof(size_t));
+	for (size_t slot = 0; slot < table->capacity; slot++)
+	{
+		table->slots[slot] = NO_STUDENT;
+	}
+	for (size_t i = 0; i < students.size; i++)
+	{
+		size_t slot = findStudentContentSlot(table, students,
+		                                     &students.data[i]);
+		if (table->slots[slot] == NO_STUDENT)
+		{
+			table->slots[slot] = i;
+		}
+	}
+}
+
+void deleteStudentContentTable(StudentContentTable *table)
+{
+	free(table->slots);
+	table->slots = NULL;
+	table->capacity = 0;
+}
+
+void encodeHistoryStudents(ByteBuffer *payload, const Student *students,
+                           size_t count)
+{
+	ByteBuffer block = { NULL, 0, 0 };
+	for (size_t first = 0; first < count; first += ARCHIVE_BLOCK_SIZE)
+	{
+		size_t length = count - first;
+		if (length > ARCHIVE_BLOCK_SIZE)
+		{
+			length = ARCHIVE_BLOCK_SIZE;
+		}
+		block.size = 0;
+		encodeArchiveBlock(&block, students + first, length);
+		putVarint(payload, block.size);
+		putBytes(payload, block.data, block.size);
+	}
+	free(block.data);
+}
+
+bool decodeHistoryStudents(ByteReader *payload, Student *students,
+                           size_t count)
+{
+	for (size_t first = 0; first < count; first += ARCHIVE_BLOCK_SIZE)
+	{
+		size_t length = count - first;
+		if (length > ARCHIVE_BLOCK_SIZE)
+		{
+			length = ARCHIVE_BLOCK_SIZE;
+		}
+		size_t blockSize = (size_t)getVarint(payload);
+		const unsigned char *bytes = getBytes(payload, blockSize);
+		if (bytes == NULL)
+		{
+			return false;
+		}
+		ByteReader block = { bytes, blockSize, 0, false };
+		if (!decodeArchiveBlock(&block, students + first, length))
+		{
+			return false;
+		}
+	}
+	return !payload->failed;
+}
+
+/*
+ * Изменение между версиями: новые записи (сжатые как блоки архива) и
+ * список операций над позициями новой версии - серия записей, оставшихся
+ * на месте, перенос записи из предыдущей версии по ее номеру или
+ * следующая новая запись. Поэтому сортировка сохраняется как перестановка,
+ * а правка одной записи - как одна новая запись.
+ * Возвращает количество новых записей.
+ */
+size_t encodeHistoryDelta(ByteBuffer *payload, StudentArray previous,
+                          StudentArray current)
+{
+	StudentContentTable table;
+	buildStudentContentTable(&table, previous);
+	
+	ByteBuffer operations = { NULL, 0, 0 };
+	size_t *added = (size_t *)malloc((current.size + 1) * sizeof(size_t));
+	size_t addedCount = 0;
+	size_t i = 0;
+	while (i < current.size)
+	{
+		size_t run = 0;
+		while (i + run < current.size && i + run < previous.size &&
+		       areStudentsEqual(&previous.data[i + run],
+		                        &current.data[i + run]))
+		{
+			run++;
+		}
+		if (run > 0)
+		{
+			putVarint(&operations, (uint64_t)run << 2 | HISTORY_OPERATION_SAME);
+			i += run;
+		}
+		else
+		{
+			size_t source = table.slots[findStudentContentSlot(
+				&table, previous, &current.data[i])];
+			if (source != NO_STUDENT)
+			{
+				putVarint(&operations,
+				          (uint64_t)source << 2 | HISTORY_OPERATION_MOVE);
+			}
+			else
+			{
+				putVarint(&operations, HISTORY_OPERATION_NEW);
+				added[addedCount++] = i;
+			}
+			i++;
+		}
+	}
+	
+	Student *addedStudents = (Student *)malloc((addedCount + 1) *
+	                                           sizeof(Student));
+	for (size_t j = 0; j < addedCount; j++)
+	{
+		copyStudent(&addedStudents[j], &current.data[added[j]]);
+	}
+	putVarint(payload, addedCount);
+	encodeHistoryStudents(payload, addedStudents, addedCount);
+	if (operations.size > 0)
+	{
+		putBytes(payload, operations.data, operations.size);
+	}
+	
+	free(addedStudents);
+	free(added);
+	free(operations.data);
+	deleteStudentContentTable(&table);
+	return addedCount;
+}
+
+bool applyHistoryDelta(ByteReader *payload, StudentArray previous,
+                       StudentArray *current, size_t size)
+{
+	size_t addedCount = (size_t)getVarint(payload);
+	if (payload->failed || addedCount > size ||
+	    size >= SIZE_MAX / sizeof(Student))
+	{
+		return false;
+	}
+	Student *added = (Student *)malloc((addedCount + 1) * sizeof(Student));
+	current->data = (Student *)malloc((size + 1) * sizeof(Student));
+	if (added == NULL || current->data == NULL)
+	{
+		free(added);
+		free(current->data);
+		current->data = NULL;
+		return false;
+	}
+	current->size = size;
+	
+	bool success = decodeHistoryStudents(payload, added, addedCount);
+	size_t position = 0;
+	size_t nextAdded = 0;
+	while (success && position < size)
+	{
+		uint64_t code = getVarint(payload);
+		uint64_t argument = code >> 2;
+		switch (code & 3)
+		{
+			case HISTORY_OPERATION_SAME:
+				success = argument != 0 && argument <= size - position &&
+				          position + argument <= previous.size;
+				if (success)
+				{
+					memcpy(&current->data[position], &previous.data[position],
+					       (size_t)argument * sizeof(Student));
+					position += (size_t)argument;
+				}
+				break;
+			case HISTORY_OPERATION_MOVE:
+				success = argument < previous.size;
+				if (success)
+				{
+					copyStudent(&current->data[position++],
+					            &previous.data[argument]);
+				}
+				break;
+			case HISTORY_OPERATION_NEW:
+				success = nextAdded < addedCount;
+				if (success)
+				{
+					copyStudent(&current->data[position++], &added[nextAdded++]);
+				}
+				break;
+			default:
+				success = false;
+		}
+		success = success && !payload->failed;
+	}
+	
+	free(added);
+	return success && nextAdded == addedCount;
+}
+
+void getHistoryFileName(const char *fileName, char *historyName)
+{
+	snprintf(historyName, STRING_BUFFER_MAX_SIZE, "%s" HISTORY_SUFFIX,
+	         fileName);
+}
+
+FILE *openNotesHistory(const char *fileName, const char *mode)
+{
+	char historyName[STRING_BUFFER_MAX_SIZE];
+	getHistoryFileName(fileName, historyName);
+	FILE *history = fopen(historyName, mode);
+	char signature[4];
+	if (history != NULL &&
+	    (fread(signature, 1, sizeof(signature), history) != sizeof(signature) ||
+	     memcmp(signature, HISTORY_SIGNATURE, sizeof(signature)) != 0))
+	{
+		fclose(history);
+		history = NULL;
+	}
+	return history;
+}
+
+bool readFileVarint(FILE *file, uint64_t *value)
+{
+	*value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		int byte = fgetc(file);
+		if (byte == EOF)
+		{
+			return false;
+		}
+		*value |= (uint64_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool readHistoryEntry(FILE *history, HistoryEntry *entry)
+{
+	int kind = fgetc(history);
+	if (kind != HISTORY_CHECKPOINT && kind != HISTORY_DELTA)
+	{
+		return false;
+	}
+	entry->kind = (HistoryEntryKind)kind;
+	
+	unsigned char checksum[8];
+	uint64_t descriptionLength;
+	if (!readFileVarint(history, &entry->version) ||
+	    !readFileVarint(history, &entry->time) ||
+	    fread(checksum, 1, sizeof(checksum), history) != sizeof(checksum) ||
+	    !readFileVarint(history, &entry->studentCount) ||
+	    !readFileVarint(history, &descriptionLength) ||
+	    descriptionLength >= STRING_BUFFER_MAX_SIZE ||
+	    fread(entry->description, 1, (size_t)descriptionLength, history) !=
+	        descriptionLength ||
+	    !readFileVarint(history, &entry->payloadLength))
+	{
+		return false;
+	}
+	entry->checksum = loadUint64(checksum);
+	entry->description[descriptionLength] = '\0';
+	entry->payloadOffset = tellFile(history);
+	return seekFile(history, entry->payloadOffset + entry->payloadLength);
+}
+
+/*
+ * Возвращает NULL, если под список версий не хватило памяти.
+ */
+HistoryEntry *readHistoryEntries(FILE *history, size_t *count)
+{
+	size_t capacity = 16;
+	HistoryEntry *entries = (HistoryEntry *)malloc(capacity *
+	                                               sizeof(HistoryEntry));
+	*count = 0;
+	if (entries == NULL)
+	{
+		return NULL;
+	}
+	seekFile(history, strlen(HISTORY_SIGNATURE));
+	while (readHistoryEntry(history, &entries[*count]))
+	{
+		if (++*count == capacity)
+		{
+			HistoryEntry *grown = NULL;
+			if (capacity <= SIZE_MAX / 2 / sizeof(HistoryEntry))
+			{
+				capacity *= 2;
+				grown = (HistoryEntry *)realloc(entries, capacity *
+				                                sizeof(HistoryEntry));
+			}
+			if (grown == NULL)
+			{
+				free(entries);
+				*count = 0;
+				return NULL;
+			}
+			entries = grown;
+		}
+	}
+	return entries;
+}
+
+bool appendHistoryEntry(FILE *history, HistoryEntryKind kind,
+                        uint64_t version, StudentArray students,
+                        const char *description, ByteBuffer payload)
+{
+	ByteBuffer header = { NULL, 0, 0 };
+	putByte(&header, (unsigned char)kind);
+	putVarint(&header, version);
+	putVarint(&header, (uint64_t)time(NULL));
+	putUint64(&header, hashStudents(students));
+	putVarint(&header, students.size);
+	putVarint(&header, strlen(description));
+	putBytes(&header, description, strlen(description));
+	putVarint(&header, payload.size);
+	
+	bool success = fseek(history, 0, SEEK_END) == 0 &&
+	               fwrite(header.data, 1, header.size, history) == header.size &&
+	               (payload.size == 0 ||
+	                fwrite(payload.data, 1, payload.size, history) ==
+	                    payload.size) &&
+	               fflush(history) == 0;
+	free(header.data);
+	return success;
+}
+
+bool appendHistoryCheckpoint(FILE *history, uint64_t version,
+                             StudentArray students, const char *description)
+{
+	ByteBuffer payload = { NULL, 0, 0 };
+	encodeHistoryStudents(&payload, students.data, students.size);
+	bool success = appendHistoryEntry(history, HISTORY_CHECKPOINT, version,
+	                                  students, description, payload);
+	free(payload.data);
+	return success;
+}
+
+/*
+ * Версия восстанавливается из ближайшей предшествующей полной копии
+ * применением изменений по порядку; контрольная сумма каждой версии
+ * сверяется с сохраненной.
+ */
+bool loadHistoryVersion(FILE *history, const HistoryEntry *entries,
+                        size_t target, StudentArray *students)
+{
+	size_t first = target;
+	while (first > 0 && entries[first].kind != HISTORY_CHECKPOINT)
+	{
+		first--;
+	}
+	
+	StudentArray current = { NULL, 0 };
+	ByteBuffer payload = { NULL, 0, 0 };
+	bool success = entries[first].kind == HISTORY_CHECKPOINT;
+	for (size_t i = first; success && i <= target; i++)
+	{
+		const HistoryEntry *entry = &entries[i];
+		success = readArchiveBlock(history, entry->payloadOffset,
+		                           entry->payloadOffset + entry->payloadLength,
+		                           &payload);
+		ByteReader reader = { payload.data, payload.size, 0, false };
+		StudentArray next = { NULL, 0 };
+		if (success && entry->kind == HISTORY_CHECKPOINT)
+		{
+			success = entry->studentCount < SIZE_MAX / sizeof(Student);
+			if (success)
+			{
+				next.size = (size_t)entry->studentCount;
+				next.data = (Student *)malloc((next.size + 1) *
+				                              sizeof(Student));
+				success = next.data != NULL &&
+				          decodeHistoryStudents(&reader, next.data, next.size);
+			}
+		}
+		else if (success)
+		{
+			success = applyHistoryDelta(&reader, current, &next,
+			                            (size_t)entry->studentCount);
+		}
+		success = success && reader.position == reader.size &&
+		          hashStudents(next) == entry->checksum;
+		free(current.data);
+		current = next;
+	}
+	free(payload.data);
+	
+	if (!success)
+	{
+		free(current.data);
+		current.data = NULL;
+		current.size = 0;
+	}
+	*students = current;
+	return success;
+}
+
+StudentArray getNotesSnapshot(const char *fileName)
+{
+	StudentArray students = { NULL, 0 };
+	FILE *history = openNotesHistory(fileName, "rb");
+	if (history != NULL)
+	{
+		fclose(history);
+		FILE *notes = fopen(fileName, "r");
+		if (notes != NULL)
+		{
+			students = getStudents(notes);
+			fclose(notes);
+		}
+	}
+	return students;
+}
+
+/*
+ * Сохраняет текущее содержимое файла записей как новую версию, если для
+ * файла ведется история. previous - содержимое файла до изменения; если
+ * оно не совпадает с последней версией (файл менялся вне программы), то
+ * сначала сохраняется его полная копия.
+ */
+void recordNotesVersion(const char *fileName, StudentArray previous,
+                        const char *description)
+{
+	FILE *history = openNotesHistory(fileName, "r+b");
+	if (history == NULL)
+	{
+		return;
+	}
+	size_t entryCount;
+	HistoryEntry *entries = readHistoryEntries(history, &entryCount);
+	if (entries == NULL)
+	{
+		fclose(history);
+		puts("Не удалось сохранить версию файла записей: недостаточно "
+		     "памяти!\n");
+		return;
+	}
+	uint64_t version = 0;
+	size_t deltaCount = 0;
+	bool synchronized = false;
+	if (entryCount > 0)
+	{
+		version = entries[entryCount - 1].version;
+		synchronized = entries[entryCount - 1].checksum ==
+		               hashStudents(previous);
+		while (deltaCount < entryCount &&
+		       entries[entryCount - 1 - deltaCount].kind == HISTORY_DELTA)
+		{
+			deltaCount++;
+		}
+	}
+	free(entries);
+	
+	bool success = true;
+	if (!synchronized)
+	{
+		success = appendHistoryCheckpoint(history, ++version, previous,
+		                                  "Изменения вне программы");
+		deltaCount = 0;
+	}
+	
+	StudentArray current = { NULL, 0 };
+	FILE *notes = fopen(fileName, "r");
+	if (notes != NULL)
+	{
+		current = getStudents(notes);
+		fclose(notes);
+	}
+	if (success && hashStudents(current) != hashStudents(previous))
+	{
+		ByteBuffer payload = { NULL, 0, 0 };
+		size_t addedCount = encodeHistoryDelta(&payload, previous, current);
+		if (deltaCount + 1 >= HISTORY_CHECKPOINT_INTERVAL ||
+		    2 * addedCount > current.size)
+		{
+			success = appendHistoryCheckpoint(history, ++version, current,
+			                                  description);
+		}
+		else
+		{
+			success = appendHistoryEntry(history, HISTORY_DELTA, ++version,
+			                             current, description, payload);
+		}
+		free(payload.data);
+	}
+	free(current.data);
+	fclose(history);
+	
+	if (success)
+	{
+		printf("Сохранена версия %" PRIu64 " файла записей.\n\n", version);
+	}
+	else
+	{
+		puts("Не удалось сохранить версию файла записей!\n");
+	}
+}
+
+void enableNotesHistory(const char *fileName)
+{
+	FILE *history = openNotesHistory(fileName, "rb");
+	if (history != NULL)
+	{
+		fclose(history);
+		puts("История версий этого файла уже ведется.\n");
+		return;
+	}
+	FILE *notes = fopen(fileName, "r");
+	if (notes == NULL)
+	{
+		puts("Не удалось открыть файл записей!\n");
+		return;
+	}
+	StudentArray students = getStudents(notes);
+	fclose(notes);
+	
+	char historyName[STRING_BUFFER_MAX_SIZE];
+	getHistoryFileName(fileName, historyName);
+	history = fopen(historyName, "w+b");
+	if (history != NULL &&
+	    fwrite(HISTORY_SIGNATURE, 1, strlen(HISTORY_SIGNATURE), history) ==
+	        strlen(HISTORY_SIGNATURE) &&
+	    appendHistoryCheckpoint(history, 1, students, "Начальная версия"))
+	{
+		puts("История версий включена, сохранена версия 1.\n");
+	}
+	else
+	{
+		puts("Не удалось создать файл истории версий!\n");
+	}
+	if (history != NULL)
+	{
+		fclose(history);
+	}
+	free(students.data);
+}
+
+void listNotesVersions(const char *fileName)
+{
+	FILE *history = openNotesHistory(fileName, "rb");
+	if (history == NULL)
+	{
+		puts("История версий этого файла не ведется.\n");
+		return;
+	}
+	size_t entryCount;
+	HistoryEntry *entries = readHistoryEntries(history, &entryCount);
+	fclose(history);
+	if (entries == NULL)
+	{
+		puts("Не удалось прочитать историю версий: недостаточно памяти!\n");
+		return;
+	}
+	
+	for (size_t i = 0; i < entryCount; i++)
+	{
+		time_t moment = (time_t)entries[i].time;
+		char date[64] = "";
+		struct tm *local = localtime(&moment);
+		if (local != NULL)
+		{
+			strftime(date, sizeof(date), "%d.%m.%Y %H:%M:%S", local);
+		}
+		printf("Версия %" PRIu64 " (%s): %s, записей: %" PRIu64 "%s\n",
+		       entries[i].version, date, entries[i].description,
+		       entries[i].studentCount,
+		       (entries[i].kind == HISTORY_CHECKPOINT) ? ", полная копия" : "");
+	}
+	putchar('\n');
+	free(entries);
+}
+
+void restoreNotesVersion(const char *fileName, uint64_t version)
+{
+	FILE *history = openNotesHistory(fileName, "rb");
+	if (history == NULL)
+	{
+		puts("История версий этого файла не ведется.\n");
+		return;
+	}
+	size_t entryCount;
+	HistoryEntry *entries = readHistoryEntries(history, &entryCount);
+	if (entries == NULL)
+	{
+		fclose(history);
+		puts("Не удалось прочитать историю версий: недостаточно памяти!\n");
+		return;
+	}
+	size_t target = 0;
+	while (target < entryCount && entries[target].version != version)
+	{
+		target++;
+	}
+	StudentArray students = { NULL, 0 };
+	bool found = target < entryCount;
+	bool success = found &&
+	               loadHistoryVersion(history, entries, target, &students);
+	free(entries);
+	fclose(history);
+	if (!found)
+	{
+		puts("Нет такой версии!\n");
+		return;
+	}
+	if (!success)
+	{
+		puts("Не удалось восстановить версию: история версий повреждена "
+		     "или недостаточно памяти!\n");
+		return;
+	}
+	
+	StudentArray previous = getNotesSnapshot(fileName);
+	FILE *notes = fopen(fileName, "w");
+	if (notes == NULL)
+	{
+		puts("Не удалось восстановить версию: не удалось открыть файл "
+		     "записей!\n");
+		free(students.data);
+		free(previous.data);
+		return;
+	}
+	writeStudentsToFile(notes, students);
+	bool written = !ferror(notes);
+	written = fclose(notes) == 0 && written;
+	free(students.data);
+	if (!written)
+	{
+		puts("Не удалось восстановить версию: ошибка записи файла "
+		     "записей!\n");
+		free(previous.data);
+		return;
+	}
+	
+	char description[STRING_BUFFER_MAX_SIZE];
+	snprintf(description, sizeof(description), "Откат к версии %" PRIu64,
+	         version);
+	printf("Файл записей восстановлен до версии %" PRIu64 ".\n", version);
+	recordNotesVersion(fileName, previous, description);
+	free(previous.data);
+}
+
+#define LIST_STATISTICS_GRADE_COLUMN(name, title) columns->name,
+#define LIST_STATISTICS_GRADE_TITLE(name, title) title,
+
+const char *const STATISTICS_VARIABLE_TITLES[] = {
+	STATISTICS_GRADES(LIST_STATISTICS_GRADE_TITLE)
+	"Средний балл"
+};
+
+const double STATISTICS_QUANTILES[] = { 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99 };
+
+void resetStatistics(StudentStatistics *statistics)
+{
+	memset(statistics, 0, sizeof(*statistics));
+	statistics->gpaMin = INFINITY;
+	statistics->gpaMax = -INFINITY;
+}
+
+size_t getGpaHistogramBin(double gpa)
+{
+	if (!(gpa > 0))
+	{
+		return 0;
+	}
+	if (gpa >= GRADE_MAX)
+	{
+		return GPA_HISTOGRAM_BINS;
+	}
+	return (size_t)(gpa * GPA_HISTOGRAM_BINS / GRADE_MAX);
+}
+
+/*
+ * Объединение по формулам Чана: средние сдвигаются к общему среднему, а к
+ * сумме моментов добавляется поправка на разность средних частей.
+ */
+void mergeStatistics(StudentStatistics *total, const StudentStatistics *part)
+{
+	if (part->count == 0)
+	{
+		return;
+	}
+	double count = (double)total->count + (double)part->count;
+	double weight = (double)total->count * (double)part->count / count;
+	double delta[STATISTICS_VARIABLE_COUNT];
+	for (int k = 0; k < STATISTICS_VARIABLE_COUNT; k++)
+	{
+		delta[k] = part->mean[k] - total->mean[k];
+	}
+	for (int k = 0; k < STATISTICS_VARIABLE_COUNT; k++)
+	{
+		for (int l = 0; l < STATISTICS_VARIABLE_COUNT; l++)
+		{
+			total->comoment[k][l] += part->comoment[k][l] +
+			                         delta[k] * delta[l] * weight;
+		}
+		total->mean[k] += delta[k] * (double)part->count / count;
+	}
+	
+	for (int k = 0; k < STATISTICS_GRADE_COUNT; k++)
+	{
+		for (int grade = 0; grade <= GRADE_MAX + 1; grade++)
+		{
+			total->gradeHistogram[k][grade] += part->gradeHistogram[k][grade];
+		}
+	}
+	for (size_t bin = 0; bin <= GPA_HISTOGRAM_BINS; bin++)
+	{
+		total->gpaHistogram[bin] += part->gpaHistogram[bin];
+	}
+	total->gpaMin = (part->gpaMin < total->gpaMin) ? part->gpaMin
+	                                               : total->gpaMin;
+	total->gpaMax = (part->gpaMax > total->gpaMax) ? part->gpaMax
+	                                               : total->gpaMax;
+	total->count += part->count;
+}
+
+/*
+ * Записи обрабатываются кусками по STATISTICS_CHUNK_SIZE: значения куска
+ * переписываются в плотные массивы values (по одному на величину), после
+ * чего суммы и попарные произведения считаются простыми циклами по
+ * массивам, которые остаются в кэше. Отклонения берутся от первой записи
+ * куска, чтобы суммы квадратов не теряли точность.
+ */
+void accumulateStatistics(StudentStatistics *statistics,
+                          const StudentColumns *columns, size_t begin,
+                          size_t end, double *values)
+{
+	const int *grades[STATISTICS_GRADE_COUNT] = {
+		STATISTICS_GRADES(LIST_STATISTICS_GRADE_COLUMN)
+	};
+	StudentStatistics chunk;
+	for (size_t first = begin; first < end; first += STATISTICS_CHUNK_SIZE)
+	{
+		size_t count = end - first;
+		if (count > STATISTICS_CHUNK_SIZE)
+		{
+			count = STATISTICS_CHUNK_SIZE;
+		}
+		resetStatistics(&chunk);
+		chunk.count = count;
+		
+		for (int k = 0; k < STATISTICS_GRADE_COUNT; k++)
+		{
+			const int *grade = grades[k] + first;
+			double *x = values + (size_t)k * STATISTICS_CHUNK_SIZE;
+			size_t *histogram = chunk.gradeHistogram[k];
+			for (size_t i = 0; i < count; i++)
+			{
+				histogram[(0 <= grade[i] && grade[i] <= GRADE_MAX)
+				          ? grade[i] : GRADE_MAX + 1]++;
+				x[i] = grade[i];
+			}
+		}
+		const double *gpa = columns->GPA + first;
+		double *x = values + (size_t)STATISTICS_GPA * STATISTICS_CHUNK_SIZE;
+		for (size_t i = 0; i < count; i++)
+		{
+			chunk.gpaHistogram[getGpaHistogramBin(gpa[i])]++;
+			chunk.gpaMin = (gpa[i] < chunk.gpaMin) ? gpa[i] : chunk.gpaMin;
+			chunk.gpaMax = (gpa[i] > chunk.gpaMax) ? gpa[i] : chunk.gpaMax;
+			x[i] = gpa[i];
+		}
+		
+		double sum[STATISTICS_VARIABLE_COUNT];
+		for (int k = 0; k < STATISTICS_VARIABLE_COUNT; k++)
+		{
+			double *xk = values + (size_t)k * STATISTICS_CHUNK_SIZE;
+			double shift = xk[0];
+			sum[k] = 0;
+			for (size_t i = 0; i < count; i++)
+			{
+				xk[i] -= shift;
+				sum[k] += xk[i];
+			}
+			chunk.mean[k] = shift + sum[k] / (double)count;
+		}
+		for (int k = 0; k < STATISTICS_VARIABLE_COUNT; k++)
+		{
+			const double *xk = values + (size_t)k * STATISTICS_CHUNK_SIZE;
+			for (int l = 0; l <= k; l++)
+			{
+				const double *xl = values + (size_t)l * STATISTICS_CHUNK_SIZE;
+				double product = 0;
+				for (size_t i = 0; i < count; i++)
+				{
+					product += xk[i] * xl[i];
+				}
+				chunk.comoment[k][l] = product - sum[k] * sum[l] /
+				                                 (double)count;
+				chunk.comoment[l][k] = chunk.comoment[k][l];
+			}
+		}
+		
+		mergeStatistics(statistics, &chunk);
+	}
+}
+
+void computeStatisticsPart(void *context, size_t index)
+{
+	StatisticsJob *job = (StatisticsJob *)context;
+	size_t size = job->columns->size;
+	size_t begin = size / job->partCount * index +
+	               size % job->partCount * index / job->partCount;
+	size_t end = size / job->partCount * (index + 1) +
+	             size % job->partCount * (index + 1) / job->partCount;
+	
+	resetStatistics(&job->partials[index]);
+	accumulateStatistics(&job->partials[index], job->columns, begin, end,
+	                     job->values + index * STATISTICS_VARIABLE_COUNT *
+	                                   STATISTICS_CHUNK_SIZE);
+}
+
+/*
+ * Буферы частичных статистик выделяются один раз на threadCount частей и
+ * используются для всех порций записей. Возвращает false, если памяти не
+ * хватило; задание после этого все равно нужно удалить.
+ */
+bool buildStatisticsJob(StatisticsJob *job, const StudentColumns *columns,
+                        size_t threadCount)
+{
+	job->columns = columns;
+	job->threadCount = threadCount;
+	job->partCount = 0;
+	job->partials = (StudentStatistics *)malloc(threadCount *
+	                                            sizeof(StudentStatistics));
+	job->values = (double *)malloc(threadCount * STATISTICS_VARIABLE_COUNT *
+	                               STATISTICS_CHUNK_SIZE * sizeof(double));
+	return job->partials != NULL && job->values != NULL;
+}
+
+void deleteStatisticsJob(StatisticsJob *job)
+{
+	free(job->values);
+	job->values = NULL;
+	free(job->partials);
+	job->partials = NULL;
+}
+
+/*
+ * Каждый поток считает частичную статистику по своему диапазону записей
+ * текущей порции, затем частичные статистики объединяются по порядку.
+ */
+void computeStatistics(StatisticsJob *job, StudentStatistics *statistics)
+{
+	size_t size = job->columns->size;
+	job->partCount = job->threadCount;
+	if (job->partCount > size / STATISTICS_CHUNK_SIZE + 1)
+	{
+		job->partCount = size / STATISTICS_CHUNK_SIZE + 1;
+	}
+	runParallel(computeStatisticsPart, job, job->partCount);
+	
+	resetStatistics(statistics);
+	for (size_t p = 0; p < job->partCount; p++)
+	{
+		mergeStatistics(statistics, &job->partials[p]);
+	}
+}
+
+/*
+ * Дописывает count значений среднего балла в массив gpa (size значений,
+ * емкость capacity удваивается). Если памяти не хватило, возвращает
+ * false, не меняя массив.
+ */
+bool appendGpaValues(double **gpa, size_t *size, size_t *capacity,
+                     const double *values, size_t count)
+{
+	if (*size + count > *capacity)
+	{
+		size_t newCapacity = *capacity;
+		while (*size + count > newCapacity)
+		{
+			if (newCapacity > SIZE_MAX / 2 / sizeof(double))
+			{
+				return false;
+			}
+			newCapacity = (newCapacity == 0) ? STATISTICS_CHUNK_SIZE
+			                                 : 2 * newCapacity;
+		}
+		double *data = (double *)realloc(*gpa, newCapacity * sizeof(double));
+		if (data == NULL)
+		{
+			return false;
+		}
+		*gpa = data;
+		*capacity = newCapacity;
+	}
+	if (count > 0)
+	{
+		memcpy(*gpa + *size, values, count * sizeof(double));
+	}
+	*size += count;
+	return true;
+}
+
+int compareDoubles(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+/*
+ * Квантиль с линейной интерполяцией между соседними по порядку
+ * значениями, как ПРОЦЕНТИЛЬ.ВКЛ в электронных таблицах.
+ */
+double getExactQuantile(const double *sorted, size_t count, double p)
+{
+	double position = p * (double)(count - 1);
+	size_t lower = (size_t)position;
+	size_t upper = (lower + 1 < count) ? lower + 1 : lower;
+	double fraction = position - (double)lower;
+	return sorted[lower] + (sorted[upper] - sorted[lower]) * fraction;
+}
+
+/*
+ * Оценка квантиля по гистограмме среднего балла с шагом
+ * GRADE_MAX / GPA_HISTOGRAM_BINS без сортировки: погрешность не больше
+ * шага гистограммы.
+ */
+double getApproximateQuantile(const StudentStatistics *statistics, double p)
+{
+	double rank = p * (double)(statistics->count - 1);
+	double width = (double)GRADE_MAX / GPA_HISTOGRAM_BINS;
+	size_t before = 0;
+	size_t bin = 0;
+	while (bin < GPA_HISTOGRAM_BINS &&
+	       (double)(before + statistics->gpaHistogram[bin]) <= rank)
+	{
+		before += statistics->gpaHistogram[bin++];
+	}
+	double value = (double)bin * width;
+	if (bin < GPA_HISTOGRAM_BINS && statistics->gpaHistogram[bin] != 0)
+	{
+		value += width * (rank - (double)before + 0.5) /
+		         (double)statistics->gpaHistogram[bin];
+	}
+	if (value < statistics->gpaMin)
+	{
+		value = statistics->gpaMin;
+	}
+	if (value > statistics->gpaMax)
+	{
+		value = statistics->gpaMax;
+	}
+	return value;
+}
+
+void printStatistics(const StudentStatistics *statistics,
+                     const double *sortedGpa)
+{
+	printf("Количество записей: %zu\n\n", statistics->count);
+	if (statistics->count == 0)
+	{
+		return;
+	}
+	
+	puts("Распределение оценок (количество студентов):");
+	printf("Оценка");
+	for (int k = 0; k < STATISTICS_GRADE_COUNT; k++)
+	{
+		printf("; %s", STATISTICS_VARIABLE_TITLES[k]);
+	}
+	putchar('\n');
+	for (int grade = 0; grade <= GRADE_MAX + 1; grade++)
+	{
+		if (grade <= GRADE_MAX)
+		{
+			printf("%d", grade);
+		}
+		else
+		{
+			printf("Вне диапазона 0-%d", GRADE_MAX);
+		}
+		for (int k = 0; k < STATISTICS_GRADE_COUNT; k++)
+		{
+			printf("; %zu", statistics->gradeHistogram[k][grade]);
+		}
+		putchar('\n');
+	}
+	putchar('\n');
+	
+	double count = (double)statistics->count;
+	double denominator = (statistics->count > 1) ? count - 1 : 1;
+	puts("Величина; среднее; дисперсия; стандартное отклонение:");
+	for (int k = 0; k < STATISTICS_VARIABLE_COUNT; k++)
+	{
+		double variance = statistics->comoment[k][k] / denominator;
+		printf("%s; %lf; %lf; %lf\n", STATISTICS_VARIABLE_TITLES[k],
+		       statistics->mean[k], variance, sqrt(variance));
+	}
+	putchar('\n');
+	
+	printf("Квантили среднего балла (точные; по гистограмме с шагом %g):\n",
+	       (double)GRADE_MAX / GPA_HISTOGRAM_BINS);
+	for (size_t q = 0;
+	     q < sizeof(STATISTICS_QUANTILES) / sizeof(STATISTICS_QUANTILES[0]);
+	     q++)
+	{
+		double p = STATISTICS_QUANTILES[q];
+		printf("%g%%; %lf; %lf\n", p * 100,
+		       getExactQuantile(sortedGpa, statistics->count, p),
+		       getApproximateQuantile(statistics, p));
+	}
+	putchar('\n');
+	
+	puts("Корреляции:");
+	for (int k = 0; k < STATISTICS_VARIABLE_COUNT; k++)
+	{
+		printf("; %s", STATISTICS_VARIABLE_TITLES[k]);
+	}
+	putchar('\n');
+	for (int k = 0; k < STATISTICS_VARIABLE_COUNT; k++)
+	{
+		printf("%s", STATISTICS_VARIABLE_TITLES[k]);
+		for (int l = 0; l < STATISTICS_VARIABLE_COUNT; l++)
+		{
+			double scale = sqrt(statistics->comoment[k][k] *
+			                    statistics->comoment[l][l]);
+			if (scale > 0)
+			{
+				printf("; %lf", statistics->comoment[k][l] / scale);
+			}
+			else
+			{
+				printf("; -");
+			}
+		}
+		putchar('\n');
+	}
+	putchar('\n');
+}
+
+/*
+ * Файл читается один раз порциями по STATISTICS_CHUNK_SIZE записей на
+ * поток: порция переписывается в столбцы и сразу учитывается в частичных
+ * статистиках потоков. В памяти кроме порции остаются только средние
+ * баллы всех записей, нужные для точных квантилей.
+ */
+void showStatistics(const char *fileName)
+{
+	FILE *notes = fopen(fileName, "r");
+	if (notes == NULL)
+	{
+		puts("Не удалось открыть файл записей!\n");
+		return;
+	}
+	size_t threadCount = getThreadCount();
+	size_t batchCapacity = threadCount * STATISTICS_CHUNK_SIZE;
+	StudentArray batch;
+	batch.data = (Student *)malloc(batchCapacity * sizeof(Student));
+	batch.size = 0;
+	StudentColumns columns;
+	bool allocated = allocateStudentColumns(&columns, batchCapacity);
+	StatisticsJob job;
+	allocated = buildStatisticsJob(&job, &columns, threadCount) &&
+	            allocated && batch.data != NULL;
+	
+	StudentStatistics statistics;
+	resetStatistics(&statistics);
+	double *gpa = NULL;
+	size_t gpaSize = 0;
+	size_t gpaCapacity = 0;
+	StudentReader reader;
+	openStudentReader(&reader, notes);
+	NotesOrder order;
+	readNotesOrder(&reader, &order);
+	bool more = allocated;
+	while (more)
+	{
+		batch.size = 0;
+		while (batch.size < batchCapacity &&
+		       readStudent(&reader, &batch.data[batch.size]))
+		{
+			batch.size++;
+		}
+		more = batch.size == batchCapacity;
+		if (batch.size == 0)
+		{
+			break;
+		}
+		fillStudentColumns(&columns, batch);
+		StudentStatistics part;
+		computeStatistics(&job, &part);
+		mergeStatistics(&statistics, &part);
+		if (!appendGpaValues(&gpa, &gpaSize, &gpaCapacity, columns.GPA,
+		                     columns.size))
+		{
+			allocated = false;
+			more = false;
+		}
+	}
+	closeStudentReader(&reader);
+	fclose(notes);
+	deleteStatisticsJob(&job);
+	deleteStudentColumns(&columns);
+	free(batch.data);
+	
+	if (!allocated)
+	{
+		puts("Недостаточно памяти для подсчета статистики!\n");
+	}
+	else
+	{
+		if (gpaSize > 0)
+		{
+			qsort(gpa, gpaSize, sizeof(double), compareDoubles);
+		}
+		printStatistics(&statistics, gpa);
+	}
+	free(gpa);
+}
+
+#define EXPORT_JSON_FIELD_STRING(output, field) outputJsonString(output, field)
+#define EXPORT_JSON_FIELD_INT(output, field) outputInt(output, field)
+#define EXPORT_JSON_FIELD_REAL(output, field) outputJsonNumber(output, field)
+
+#define EXPORT_CSV_FIELD_STRING(output, field) outputCsvString(output, field)
+#define EXPORT_CSV_FIELD_INT(output, field) outputInt(output, field)
+#define EXPORT_CSV_FIELD_REAL(output, field) outputFixed(output, field)
+
+#define EXPORT_STUDENT_FIELD_JSON(name, type, ...) \
+	outputString(output, separator); \
+	outputString(output, #name "\":"); \
+	EXPORT_JSON_FIELD_##type(output, student->name); \
+	separator = ",\"";
+#define EXPORT_STUDENT_FIELD_CSV(name, type, ...) \
+	outputString(output, separator); \
+	EXPORT_CSV_FIELD_##type(output, student->name); \
+	separator = ",";
+#define EXPORT_CSV_HEADER_FIELD(name, ...) \
+	outputString(output, separator); \
+	outputString(output, #name); \
+	separator = ",";
+
+/*
+ * Строка JSON пишется прямо в буфер вывода: кавычки, обратная косая черта
+ * и управляющие символы экранируются, некорректные последовательности
+ * UTF-8 заменяются на U+FFFD, чтобы результат всегда был корректным JSON.
+ */
+void outputJsonString(OutputBuffer *output, const char *s)
+{
+	static const char HEX_DIGITS[] = "0123456789abcdef";
+	size_t length = strlen(s);
+	if (6 * length + 2 > output->capacity)
+	{
+		length = (output->capacity - 2) / 6;
+	}
+	char *begin = reserveOutput(output, 6 * length + 2);
+	char *end = begin;
+	*end++ = '"';
+	const unsigned char *c = (const unsigned char *)s;
+	const unsigned char *last = c + length;
+	while (c < last)
+	{
+		if (*c >= 0x80)
+		{
+			size_t sequence = getUtf8SequenceLength(c);
+			if (sequence != 0 && sequence <= (size_t)(last - c))
+			{
+				memcpy(end, c, sequence);
+				end += sequence;
+				c += sequence;
+			}
+			else
+			{
+				memcpy(end, "\\ufffd", 6);
+				end += 6;
+				c++;
+			}
+			continue;
+		}
+		switch (*c)
+		{
+			case '"':
+			case '\\':
+				*end++ = '\\';
+				*end++ = (char)*c;
+				break;
+			case '\n':
+				*end++ = '\\';
+				*end++ = 'n';
+				break;
+			case '\r':
+				*end++ = '\\';
+				*end++ = 'r';
+				break;
+			case '\t':
+				*end++ = '\\';
+				*end++ = 't';
+				break;
+			default:
+				if (*c < 0x20)
+				{
+					memcpy(end, "\\u00", 4);
+					end[4] = HEX_DIGITS[*c >> 4];
+					end[5] = HEX_DIGITS[*c & 0xF];
+					end += 6;
+				}
+				else
+				{
+					*end++ = (char)*c;
+				}
+		}
+		c++;
+	}
+	*end++ = '"';
+	output->size += (size_t)(end - begin);
+}
+
+void outputJsonNumber(OutputBuffer *output, double value)
+{
+	if (isfinite(value))
+	{
+		outputFixed(output, value);
+	}
+	else
+	{
+		outputBytes(output, "null", 4);
+	}
+}
+
+/*
+ * Поле CSV заключается в кавычки (с удвоением кавычек внутри), только
+ * если содержит разделитель, кавычку, перевод строки или пробелы по краям.
+ */
+void outputCsvString(OutputBuffer *output, const char *s)
+{
+	size_t length = strlen(s);
+	if (length > 0 && strpbrk(s, ",\"\r\n") == NULL && s[0] != ' ' &&
+	    s[length - 1] != ' ')
+	{
+		outputBytes(output, s, length);
+		return;
+	}
+	char *begin = reserveOutput(output, 2 * length + 2);
+	char *end = begin;
+	*end++ = '"';
+	for (const char *c = s; *c != '\0'; c++)
+	{
+		if (*c == '"')
+		{
+			*end++ = '"';
+		}
+		*end++ = *c;
+	}
+	*end++ = '"';
+	output->size += (size_t)(end - begin);
+}
+
+void outputStudentJson(OutputBuffer *output, const Student *student)
+{
+	const char *separator = "{\"";
+	STUDENT_FIELDS(EXPORT_STUDENT_FIELD_JSON)
+	outputBytes(output, "}", 1);
+}
+
+void outputStudentCsv(OutputBuffer *output, const Student *student)
+{
+	const char *separator = "";
+	STUDENT_FIELDS(EXPORT_STUDENT_FIELD_CSV)
+	outputBytes(output, "\n", 1);
+}
+
+void openExportBuffer(OutputBuffer *output, FILE *stream)
+{
+	openOutputBuffer(output, stream);
+	output->decimalPoint = '.';
+}
+
+void outputExportHeader(OutputBuffer *output, ExportFormat format)
+{
+	if (format == EXPORT_JSON)
+	{
+		outputBytes(output, "[", 1);
+		return;
+	}
+	const char *separator = "";
+	STUDENT_FIELDS(EXPORT_CSV_HEADER_FIELD)
+	outputBytes(output, "\n", 1);
+}
+
+void outputExportFooter(OutputBuffer *output, ExportFormat format,
+                        size_t count)
+{
+	if (format == EXPORT_JSON)
+	{
+		outputString(output, (count == 0) ? "]\n" : "\n]\n");
+	}
+}
+
+/*
+ * Читает записи, чтение которых начинается до смещения end в файле, и
+ * выводит их в выбранном формате; first - номер первой из них во всем
+ * файле (перед записями JSON, кроме самой первой, ставится запятая).
+ * Память на каждую запись не выделяется.
+ */
+size_t exportStudents(StudentReader *reader, OutputBuffer *output,
+                      ExportFormat format, size_t first, uint64_t end)
+{
+	Student student;
+	size_t count = 0;
+	while (getStudentReaderOffset(reader) < end &&
+	       readStudent(reader, &student))
+	{
+		if (format == EXPORT_JSON)
+		{
+			outputString(output, (first + count == 0) ? "\n" : ",\n");
+			outputStudentJson(output, &student);
+		}
+		else
+		{
+			outputStudentCsv(output, &student);
+		}
+		count++;
+	}
+	return count;
+}
+
+void exportPart(void *context, size_t index)
+{
+	ExportJob *job = (ExportJob *)context;
+	size_t blockCount = job->index->count;
+	size_t begin = blockCount * index / job->partCount;
+	size_t end = blockCount * (index + 1) / job->partCount;
+	job->parts[index] = NULL;
+	job->counts[index] = 0;
+	job->failures[index] = false;
+	if (begin == end)
+	{
+		return;
+	}
+	
+	FILE *notes = fopen(job->fileName, "rb");
+	FILE *part = tmpfile();
+	if (notes == NULL || part == NULL)
+	{
+		job->failures[index] = true;
+	}
+	else
+	{
+		StudentReader reader;
+		openStudentReader(&reader, notes);
+		OutputBuffer output;
+		openExportBuffer(&output, part);
+		uint64_t stop = (end == blockCount) ? UINT64_MAX
+		                                    : job->index->offsets[end];
+		if (seekStudentReader(&reader, job->index->offsets[begin]))
+		{
+			job->counts[index] = exportStudents(&reader, &output, job->format,
+			                                    begin * NOTES_INDEX_STRIDE,
+			                                    stop);
+		}
+		closeOutputBuffer(&output);
+		closeStudentReader(&reader);
+		job->failures[index] = ferror(part) != 0;
+	}
+	if (notes != NULL)
+	{
+		fclose(notes);
+	}
+	job->parts[index] = part;
+}
+
+/*
+ * Параллельный экспорт: файл делится на части по разреженному индексу
+ * записей, каждый поток разбирает и форматирует свою часть во временный
+ * файл, затем части дописываются в результат по порядку.
+ */
+bool exportNotesParallel(const char *fileName, const NotesIndex *index,
+                         ExportFormat format, size_t partCount,
+                         FILE *destination, size_t *count)
+{
+	ExportJob job;
+	job.fileName = fileName;
+	job.index = index;
+	job.format = format;
+	job.partCount = partCount;
+	job.parts = (FILE **)malloc(partCount * sizeof(FILE *));
+	job.counts = (size_t *)malloc(partCount * sizeof(size_t));
+	job.failures = (bool *)malloc(partCount * sizeof(bool));
+	runParallel(exportPart, &job, partCount);
+	
+	bool success = true;
+	for (size_t p = 0; p < partCount; p++)
+	{
+		success = success && !job.failures[p];
+	}
+	for (size_t p = 0; p < partCount; p++)
+	{
+		if (job.parts[p] != NULL)
+		{
+			if (success)
+			{
+				copyFileContents(job.parts[p], destination);
+				*count += job.counts[p];
+			}
+			fclose(job.parts[p]);
+		}
+	}
+	
+	free(job.failures);
+	free(job.counts);
+	free(job.parts);
+	return success;
+}
+
+void exportNotes(const char *fileName, const char *exportName,
+                 ExportFormat format)
+{
+	FILE *notes = fopen(fileName, "rb");
+	if (notes == NULL)
+	{
+		puts("Не удалось открыть файл записей!\n");
+		return;
+	}
+	FILE *destination = fopen(exportName, "wb");
+	if (destination == NULL)
+	{
+		fclose(notes);
+		puts("Не удалось создать файл для экспорта!\n");
+		return;
+	}
+	double start = getMonotonicTime();
+	
+	OutputBuffer output;
+	openExportBuffer(&output, destination);
+	outputExportHeader(&output, format);
+	size_t count = 0;
+	bool exported = false;
+	size_t partCount = getThreadCount();
+	if (partCount > 1)
+	{
+		NotesIndex index;
+		buildNotesIndex(notes, &index);
+		if (index.studentCount >= EXPORT_PARALLEL_MIN_SIZE)
+		{
+			flushOutputBuffer(&output);
+			exported = exportNotesParallel(fileName, &index, format, partCount,
+			                               destination, &count);
+			if (!exported)
+			{
+				puts("Не удалось выполнить параллельный экспорт, записи будут "
+				     "экспортированы в одном потоке.");
+			}
+		}
+		deleteNotesIndex(&index);
+		rewind(notes);
+	}
+	if (!exported)
+	{
+		StudentReader reader;
+		openStudentReader(&reader, notes);
+		NotesOrder order;
+		readNotesOrder(&reader, &order);
+		count = exportStudents(&reader, &output, format, 0, UINT64_MAX);
+		closeStudentReader(&reader);
+	}
+	outputExportFooter(&output, format, count);
+	closeOutputBuffer(&output);
+	
+	double seconds = getMonotonicTime() - start;
+	uint64_t size = getFileSize(notes);
+	fclose(notes);
+	bool failed = ferror(destination) != 0;
+	fclose(destination);
+	
+	if (failed)
+	{
+		puts("Не удалось записать файл экспорта!\n");
+		return;
+	}
+	printf("Экспортировано записей: %zu\n", count);
+	printThroughput("Экспорт", size, count, seconds);
+	putchar('\n');
+}
+
+/*
+ * Путь к файлу части берется из манифеста как есть, если он абсолютный,
+ * иначе отсчитывается от каталога, в котором лежит манифест.
+ */
+char *getShardFileName(const char *manifestName, const char *path)
+{
+	size_t directoryLength = 0;
+	bool absolute = path[0] == '/' || path[0] == '\\' ||
+	                (path[0] != '\0' && path[1] == ':');
+	if (!absolute)
+	{
+		for (size_t i = 0; manifestName[i] != '\0'; i++)
+		{
+			if (manifestName[i] == '/' || manifestName[i] == '\\')
+			{
+				directoryLength = i + 1;
+			}
+		}
+	}
+	size_t pathLength = strlen(path);
+	char *fileName = (char *)malloc(directoryLength + pathLength + 1);
+	memcpy(fileName, manifestName, directoryLength);
+	memcpy(fileName + directoryLength, path, pathLength + 1);
+	return fileName;
+}
+
+/*
+ * Манифест реестра - текстовый файл, в котором на каждой строке указан
+ * файл записей одной части. Пустые строки и строки, начинающиеся с '#',
+ * пропускаются.
+ */
+bool readShardManifest(const char *manifestName, ShardManifest *manifest)
+{
+	manifest->files = NULL;
+	manifest->count = 0;
+	FILE *file = fopen(manifestName, "r");
+	if (file == NULL)
+	{
+		return false;
+	}
+	size_t capacity = 0;
+	char line[STRING_BUFFER_MAX_SIZE];
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		size_t length = strcspn(line, "\r\n");
+		while (length > 0 &&
+		       (line[length - 1] == ' ' || line[length - 1] == '\t'))
+		{
+			length--;
+		}
+		line[length] = '\0';
+		const char *path = skipBlanks(line);
+		if (*path == '\0' || *path == '#')
+		{
+			continue;
+		}
+		if (manifest->count == capacity)
+		{
+			capacity = (capacity == 0) ? 8 : 2 * capacity;
+			manifest->files = (char **)realloc(manifest->files,
+			                                   capacity * sizeof(char *));
+		}
+		manifest->files[manifest->count++] = getShardFileName(manifestName,
+		                                                      path);
+	}
+	fclose(file);
+	return manifest->count > 0;
+}
+
+void deleteShardManifest(ShardManifest *manifest)
+{
+	for (size_t i = 0; i < manifest->count; i++)
+	{
+		free(manifest->files[i]);
+	}
+	free(manifest->files);
+	manifest->files = NULL;
+	manifest->count = 0;
+}
+
+void createShardedRegistry(const char *manifestName, size_t shardCount)
+{
+	const char *baseName = manifestName;
+	for (const char *c = manifestName; *c != '\0'; c++)
+	{
+		if (*c == '/' || *c == '\\')
+		{
+			baseName = c + 1;
+		}
+	}
+	FILE *manifest = fopen(manifestName, "w");
+	if (manifest == NULL)
+	{
+		puts("Не удалось создать манифест реестра!\n");
+		return;
+	}
+	fputs("# Файлы записей частей реестра\n", manifest);
+	bool success = true;
+	for (size_t i = 0; i < shardCount; i++)
+	{
+		fprintf(manifest, "%s.%zu\n", baseName, i);
+		char path[STRING_BUFFER_MAX_SIZE];
+		snprintf(path, sizeof(path), "%s.%zu", baseName, i);
+		char *shardName = getShardFileName(manifestName, path);
+		FILE *shard = fopen(shardName, "w");
+		free(shardName);
+		if (shard == NULL)
+		{
+			success = false;
+			continue;
+		}
+		fclose(shard);
+	}
+	success = fclose(manifest) == 0 && success;
+	puts(success ? "Реестр создан.\n" : "Не удалось создать файлы реестра!\n");
+}
+
+/*
+ * Часть для новой записи выбирается по хешу номера группы, поэтому все
+ * студенты одной группы попадают в один файл.
+ */
+size_t getShardIndex(int group, size_t shardCount)
+{
+	return (size_t)(hashValue(14695981039346656037ULL, (uint32_t)group) %
+	                shardCount);
+}
+
+void addShardedNote(const char *manifestName)
+{
+	ShardManifest manifest;
+	if (!readShardManifest(manifestName, &manifest))
+	{
+		deleteShardManifest(&manifest);
+		puts("Не удалось прочитать манифест реестра!\n");
+		return;
+	}
+	char values[STUDENT_FIELD_COUNT][STRING_BUFFER_MAX_SIZE];
+	Student student;
+	if (scanNote(&student, values))
+	{
+		const char *fileName =
+			manifest.files[getShardIndex(student.group, manifest.count)];
+		StudentArray previous = getNotesSnapshot(fileName);
+		FILE *notes = fopen(fileName, "a");
+		if (notes == NULL)
+		{
+			printf("Не удалось открыть файл %s!\n\n", fileName);
+		}
+		else
+		{
+			writeNote(notes, values);
+			fclose(notes);
+			printf("Запись добавлена в файл %s.\n\n", fileName);
+			recordNotesVersion(fileName, previous, "Добавление записи");
+		}
+		free(previous.data);
+	}
+	deleteShardManifest(&manifest);
+}
+
+/*
+ * Вставляет запись в упорядоченный по критерию список из не более чем
+ * limit записей. Равные записи остаются в порядке поступления.
+ */
+void insertTopStudent(StudentArray *top, size_t limit, const Student *student,
+                      int criterion)
+{
+	size_t low = 0;
+	size_t high = top->size;
+	while (low < high)
+	{
+		size_t middle = low + (high - low) / 2;
+		if (isSorted(student, &top->data[middle], criterion))
+		{
+			high = middle;
+		}
+		else
+		{
+			low = middle + 1;
+		}
+	}
+	if (low >= limit)
 	{
-		printf("%c", current);
+		return;
 	}
-}
-
-void swapStudents(Student *s1, Student *s2)
-{
-	if (s1 != s2)
+	size_t moved = (top->size < limit) ? top->size - low : top->size - low - 1;
+	memmove(&top->data[low + 1], &top->data[low], moved * sizeof(Student));
+	memcpy(&top->data[low], student, sizeof(Student));
+	if (top->size < limit)
 	{
-		Student tmp;
-		strcpy(tmp.surname, s1->surname);
-		tmp.group = s1->group;
-		tmp.physicsGrade = s1->physicsGrade;
-		tmp.mathsGrade = s1->mathsGrade;
-		tmp.informaticsGrade = s1->informaticsGrade;
-		tmp.GPA = s1->GPA;
-		
-		strcpy(s1->surname, s2->surname);
-		s1->group = s2->group;
-		s1->physicsGrade = s2->physicsGrade;
-		s1->mathsGrade = s2->mathsGrade;
-		s1->informaticsGrade = s2->informaticsGrade;
-		s1->GPA = s2->GPA;
-		
-		strcpy(s2->surname, tmp.surname);
-		s2->group = tmp.group;
-		s2->physicsGrade = tmp.physicsGrade;
-		s2->mathsGrade = tmp.mathsGrade;
-		s2->informaticsGrade = tmp.informaticsGrade;
-		s2->GPA = tmp.GPA;
+		top->size++;
 	}
 }
 
-void createFile(const char *fileName)
+bool isStudentInRange(const Student *student, const ShardQuery *query)
 {
-	FILE *f = fopen(fileName, "w");
-	fclose(f);
-	puts("Файл создан.\n");
+	double value = (STUDENT_FIELD_DESCRIPTORS[query->field].type ==
+	                FIELD_TYPE_INT)
+	               ? *CONST_STUDENT_FIELD_AT(student, query->field, int)
+	               : *CONST_STUDENT_FIELD_AT(student, query->field, double);
+	return query->minimum <= value && value <= query->maximum;
 }
 
-void viewFile(StudentArray students)
+bool accumulateShardStatistics(ShardResult *result, StudentArray chunk,
+                               size_t *gpaCapacity, double *values)
 {
-	for (size_t i = 0; i < students.size; i++)
+	StudentColumns columns;
+	if (!getStudentColumns(chunk, &columns))
 	{
-		printf("Фамилия: %s\n", students.data[i].surname);
-		printf("Номер группы: %d\n", students.data[i].group);
-		printf("Оценка за семестр по физике: %d\n",
-		       students.data[i].physicsGrade);
-		printf("Оценка за семестр по математике: %d\n",
-		       students.data[i].mathsGrade);
-		printf("Оценка за семестр по информатике: %d\n",
-		       students.data[i].informaticsGrade);
-		printf("Средний балл студента: %lf\n\n",
-		       students.data[i].GPA);
+		return false;
 	}
+	bool appended = appendGpaValues(&result->gpa, &result->matched,
+	                                gpaCapacity, columns.GPA, columns.size);
+	if (appended)
+	{
+		accumulateStatistics(&result->statistics, &columns, 0, columns.size,
+		                     values);
+	}
+	deleteStudentColumns(&columns);
+	return appended;
 }
 
-void addNote(FILE *notes)
+/*
+ * Выполняет запрос над одной частью реестра. Части обрабатываются
+ * независимо, результаты объединяются после завершения всех потоков.
+ */
+void queryShard(void *context, size_t index)
 {
-	puts("Введите фамилию студента:");
-	char surname[STRING_BUFFER_MAX_SIZE];
-	scanf("%s", surname);
+	ShardJob *job = (ShardJob *)context;
+	const ShardQuery *query = job->query;
+	ShardResult *result = &job->results[index];
+	result->opened = false;
+	result->scanned = 0;
+	result->students.data = NULL;
+	result->students.size = 0;
+	result->part = NULL;
+	result->matched = 0;
+	result->gpa = NULL;
+	resetStatistics(&result->statistics);
 	
-	puts("Введите номер группы студента:");
-	char group[STRING_BUFFER_MAX_SIZE];
-	scanf("%s", group);
-	
-	puts("Введите оценку за семестр студента по физике:");
-	char physicsGrade[STRING_BUFFER_MAX_SIZE];
-	scanf("%s", physicsGrade);
-	
-	puts("Введите оценку за семестр студента по математике:");
-	char mathsGrade[STRING_BUFFER_MAX_SIZE];
-	scanf("%s", mathsGrade);
-	
-	puts("Введите оценку за семестр студента по информатике:");
-	char informaticsGrade[STRING_BUFFER_MAX_SIZE];
-	scanf("%s", informaticsGrade);
-	
-	puts("Введите средний балл студента:");
-	char GPA[STRING_BUFFER_MAX_SIZE];
-	scanf("%s", GPA);
+	FILE *notes = fopen(job->manifest->files[index], "rb");
+	if (notes == NULL)
+	{
+		return;
+	}
+	OutputBuffer output;
+	StudentArray chunk = { NULL, 0 };
+	double *values = NULL;
+	size_t gpaCapacity = 0;
+	size_t capacity = 0;
+	switch (query->kind)
+	{
+		case SHARD_QUERY_FILTER:
+			result->part = tmpfile();
+			if (result->part == NULL)
+			{
+				fclose(notes);
+				return;
+			}
+			openOutputBuffer(&output, result->part);
+			break;
+		case SHARD_QUERY_TOP:
+			result->students.data = (Student *)malloc((query->limit + 1) *
+			                                          sizeof(Student));
+			break;
+		case SHARD_QUERY_STATISTICS:
+			chunk.data = (Student *)malloc(STATISTICS_CHUNK_SIZE *
+			                               sizeof(Student));
+			values = (double *)malloc(STATISTICS_VARIABLE_COUNT *
+			                          STATISTICS_CHUNK_SIZE * sizeof(double));
+			break;
+		default:
+			break;
+	}
+	bool failed = (query->kind == SHARD_QUERY_TOP &&
+	               result->students.data == NULL) ||
+	              (query->kind == SHARD_QUERY_STATISTICS &&
+	               (chunk.data == NULL || values == NULL));
 	
-	fprintf(notes, "%s\n%s\n%s\n%s\n%s\n%s\n\n", surname, group,
-	        physicsGrade, mathsGrade, informaticsGrade, GPA);
+	StudentReader reader;
+	openStudentReader(&reader, notes);
+	NotesOrder order;
+	readNotesOrder(&reader, &order);
+	Student student;
+	while (!failed && readStudent(&reader, &student))
+	{
+		result->scanned++;
+		switch (query->kind)
+		{
+			case SHARD_QUERY_SEARCH:
+				if (strcmp(student.surname, query->surname) == 0)
+				{
+					failed = !addStudent(&result->students, &capacity,
+					                     &student);
+					result->matched++;
+				}
+				break;
+			case SHARD_QUERY_FILTER:
+				if (isStudentInRange(&student, query))
+				{
+					outputStudent(&output, &student);
+					result->matched++;
+				}
+				break;
+			case SHARD_QUERY_TOP:
+				insertTopStudent(&result->students, query->limit, &student,
+				                 query->criterion);
+				break;
+			case SHARD_QUERY_STATISTICS:
+				chunk.data[chunk.size++] = student;
+				if (chunk.size == STATISTICS_CHUNK_SIZE)
+				{
+					failed = !accumulateShardStatistics(result, chunk,
+					                                    &gpaCapacity, values);
+					chunk.size = 0;
+				}
+				break;
+		}
+	}
+	closeStudentReader(&reader);
+	fclose(notes);
 	
-	puts("Запись добавлена.\n");
+	if (query->kind == SHARD_QUERY_FILTER)
+	{
+		closeOutputBuffer(&output);
+	}
+	else if (query->kind == SHARD_QUERY_TOP)
+	{
+		result->matched = result->students.size;
+	}
+	else if (query->kind == SHARD_QUERY_STATISTICS)
+	{
+		if (!failed && chunk.size > 0)
+		{
+			failed = !accumulateShardStatistics(result, chunk, &gpaCapacity,
+			                                    values);
+		}
+		free(chunk.data);
+		free(values);
+	}
+	/*
+	 * Если памяти не хватило, часть считается непрочитанной, чтобы неполный
+	 * результат не попал в общий.
+	 */
+	result->opened = !failed;
 }
 
-void solveIndividualTask(FILE *output, StudentArray students)
+void printShardedSearch(const ShardManifest *manifest, ShardResult *results)
 {
-	for (size_t i = 0; i < students.size; i++)
+	bool found = false;
+	for (size_t i = 0; i < manifest->count; i++)
 	{
-		if ((students.data[i].physicsGrade == 4 ||
-		     students.data[i].physicsGrade == 5) &&
-		    (students.data[i].mathsGrade > 8 &&
-		     students.data[i].informaticsGrade > 8))
+		if (results[i].students.size > 0)
 		{
-			fprintf(output, "Фамилия: %s\n", students.data[i].surname);
-			fprintf(output, "Номер группы: %d\n", students.data[i].group);
-			fprintf(output, "Оценка за семестр по физике: %d\n",
-			        students.data[i].physicsGrade);
-			fprintf(output, "Оценка за семестр по математике: %d\n",
-			        students.data[i].mathsGrade);
-			fprintf(output, "Оценка за семестр по информатике: %d\n",
-			        students.data[i].informaticsGrade);
-			fprintf(output, "Средний балл студента: %lf\n\n",
-			        students.data[i].GPA);
+			printf("%s:\n\n", manifest->files[i]);
+			viewFile(results[i].students);
+			found = true;
 		}
 	}
-	
-	puts("Решение индивидуального задания записано в файл.\n");
+	if (!found)
+	{
+		puts("Нет такого студента!\n");
+	}
 }
 
-void editNote(StudentArray *students)
+/*
+ * Лучшие K записей каждой части уже упорядочены; общий список получается
+ * вставкой их по порядку частей, поэтому результат совпадает с первыми K
+ * записями устойчивой сортировки объединенного файла.
+ */
+void printShardedTop(const ShardManifest *manifest, ShardResult *results,
+                     const ShardQuery *query)
 {
-	puts("Введите фамилию студента, информацию о котором необходимо "
-		 "редактировать:");
-	char changingStudentsSurname[STRING_BUFFER_MAX_SIZE];
-	scanf("%s", changingStudentsSurname);
-	
-	for (size_t i = 0; i < students->size; i++)
+	StudentArray top;
+	top.data = (Student *)malloc((query->limit + 1) * sizeof(Student));
+	top.size = 0;
+	for (size_t i = 0; i < manifest->count; i++)
 	{
-		if (strcmp(students->data[i].surname, changingStudentsSurname) == 0)
+		for (size_t j = 0; j < results[i].students.size; j++)
 		{
-			int option = 1;
-			while (1 <= option && option <= 6)
-			{
-				puts("Выберите информацию о студенте, которую хотите "
-				     "редактиорвать:\n"
-				     "1. Фамилия.\n"
-				     "2. Номер группы.\n"
-				     "3. Оценка за семестр по физике.\n"
-				     "4. Оценка за семетр по математике.\n"
-				     "5. Оценка за семестр по информатике.\n"
-				     "6. Средний балл студента.\n"
-					 "Любое другое число - выход из режима изменения");
-				
-				scanf("%d", &option);
-				
-				switch (option)
-				{
-					case 1:
-						puts("Введите новую фамилию студента:");
-						char surname[STRING_BUFFER_MAX_SIZE];
-						scanf("%s", surname);
-						strcpy(students->data[i].surname, surname);
-						break;
-					case 2:
-						puts("Введите новый номер группы студента:");
-						int group;
-						scanf("%d", &group);
-						students->data[i].group = group;
-						break;
-					case 3:
-						puts("Введите новую оценку за семемтр по физике "
-							 "студента:");
-						int physicsGrade;
-						scanf("%d", &physicsGrade);
-						students->data[i].physicsGrade = physicsGrade;
-						break;
-					case 4:
-						puts("Введите новую оценку за семемтр по математике "
-						     "студента:");
-						int mathsGrade;
-						scanf("%d", &mathsGrade);
-						students->data[i].physicsGrade = mathsGrade;
-						break;
-					case 5:
-						puts("Введите новую оценку за семемтр по информатике "
-						     "студента:");
-						int informaticsGrade;
-						scanf("%d", &informaticsGrade);
-						students->data[i].informaticsGrade = informaticsGrade;
-						break;
-					case 6:
-						puts("Введите новый средний балл студента:");
-						double GPA;
-						scanf("%lf", &GPA);
-						students->data[i].GPA = GPA;
-						break;
-					default:
-						puts("Выход из режимы изменения...");
-				}
-			}
-			puts("Запись изменена.\n");
-			return;
+			insertTopStudent(&top, query->limit, &results[i].students.data[j],
+			                 query->criterion);
 		}
 	}
-	puts("Нет такого студента!\n");
+	viewFile(top);
+	free(top.data);
 }
 
-void removeNote(StudentArray *students)
+bool writeShardedFilter(const ShardManifest *manifest, ShardResult *results,
+                        const char *outputFileName)
 {
-	puts("Введите фамилию студента, информацию о котором необходимо "
-	     "удалить (после удаления информации порядок следования студентов "
-		 "в файле может быть нарушен):");
-	char removingStudentsSurname[STRING_BUFFER_MAX_SIZE];
-	scanf("%s", removingStudentsSurname);
-	
-	for (size_t i = 0; i < students->size; i++)
+	for (size_t i = 0; i < manifest->count; i++)
 	{
-		if (strcmp(students->data[i].surname, removingStudentsSurname) == 0)
+		if (results[i].opened &&
+		    (results[i].part == NULL || ferror(results[i].part)))
 		{
-			swapStudents(&students->data[i],
-						 &students->data[students->size - 1]);
-			removeLastStudent(students);
-			puts("Запись удалена.\n");
-			return;
+			return false;
 		}
 	}
-	puts("Нет такого студента!\n");
+	FILE *output = fopen(outputFileName, "wb");
+	if (output == NULL)
+	{
+		return false;
+	}
+	for (size_t i = 0; i < manifest->count; i++)
+	{
+		if (results[i].part != NULL)
+		{
+			copyFileContents(results[i].part, output);
+		}
+	}
+	bool failed = ferror(output) != 0;
+	return fclose(output) == 0 && !failed;
 }
 
-bool isSorted(Student s1, Student s2, int criterion)
+void printShardedStatistics(const ShardManifest *manifest,
+                            ShardResult *results)
 {
-	switch (criterion)
+	StudentStatistics statistics;
+	resetStatistics(&statistics);
+	size_t count = 0;
+	for (size_t i = 0; i < manifest->count; i++)
 	{
-		case 1:
-			return strcmp(s1.surname, s2.surname) < 0;
-		case 2:
-			return s1.physicsGrade < s2.physicsGrade;
-		case 3:
-			return s1.physicsGrade > s2.physicsGrade;
-		case 4:
-			return s1.mathsGrade < s2.mathsGrade;
-		case 5:
-			return s1.mathsGrade > s2.mathsGrade;
-		case 6:
-			return s1.informaticsGrade < s2.informaticsGrade;
-		case 7:
-			return s1.informaticsGrade > s2.informaticsGrade;
-		case 8:
-			return s1.GPA < s2.GPA;
-		case 9:
-			return s1.GPA > s2.GPA;
-		default:
-			return false; // never get there
+		mergeStatistics(&statistics, &results[i].statistics);
+		count += results[i].matched;
+	}
+	double *sortedGpa = (double *)malloc((count + 1) * sizeof(double));
+	size_t position = 0;
+	for (size_t i = 0; i < manifest->count; i++)
+	{
+		if (results[i].matched > 0)
+		{
+			memcpy(sortedGpa + position, results[i].gpa,
+			       results[i].matched * sizeof(double));
+			position += results[i].matched;
+		}
 	}
+	qsort(sortedGpa, count, sizeof(double), compareDoubles);
+	printStatistics(&statistics, sortedGpa);
+	free(sortedGpa);
 }
 
-void sortNotes(StudentArray *students)
+/*
+ * Запрос к реестру из нескольких файлов: каждая часть обрабатывается
+ * отдельным заданием пула потоков, затем частичные результаты
+ * объединяются в порядке частей в манифесте.
+ */
+void queryShardedRegistry(const char *manifestName, const ShardQuery *query,
+                          const char *outputFileName)
 {
-	puts("Выберите критерий, по которому будет проводиться сортировка:\n"
-		 "1. По алфавиту (фамилия).\n"
-		 "2. По возрастанию оценки по физике.\n"
-		 "3. По убыванию оценки по физике.\n"
-		 "4. По возрастанию оценки по математике.\n"
-	     "5. По убыванию оценки по математике.\n"
-		 "6. По возрастанию оценки по информатике.\n"
-		 "7. По убыванию оценки по информатике.\n"
-	     "8. По возрастанию среднего балла.\n"
-	     "9. По убыванию среднего балла.\n"
-		 "Любое другое число - сортировка не производится.");
-	int option;
-	scanf("%d", &option);
+	ShardManifest manifest;
+	if (!readShardManifest(manifestName, &manifest))
+	{
+		deleteShardManifest(&manifest);
+		puts("Не удалось прочитать манифест реестра!\n");
+		return;
+	}
+	double start = getMonotonicTime();
+	ShardJob job;
+	job.manifest = &manifest;
+	job.query = query;
+	job.results = (ShardResult *)malloc(manifest.count * sizeof(ShardResult));
+	runWorkQueue(queryShard, &job, manifest.count);
 	
-	if (1 <= option && option <= 9)
+	switch (query->kind)
 	{
-		for (size_t i = 0; i < students->size; i++)
-		{
-			for (size_t j = i + 1; j < students->size; j++)
+		case SHARD_QUERY_SEARCH:
+			printShardedSearch(&manifest, job.results);
+			break;
+		case SHARD_QUERY_FILTER:
+			if (writeShardedFilter(&manifest, job.results, outputFileName))
 			{
-				if (!isSorted(students->data[i],
-							  students->data[j], option))
-				{
-					swapStudents(&students->data[i], &students->data[j]);
-				}
+				puts("Отобранные записи записаны в файл.\n");
 			}
+			else
+			{
+				puts("Не удалось записать отобранные записи!\n");
+			}
+			break;
+		case SHARD_QUERY_TOP:
+			printShardedTop(&manifest, job.results, query);
+			break;
+		case SHARD_QUERY_STATISTICS:
+			printShardedStatistics(&manifest, job.results);
+			break;
+	}
+	double seconds = getMonotonicTime() - start;
+	
+	puts("Файл части; просмотрено записей; отобрано записей");
+	size_t scanned = 0;
+	for (size_t i = 0; i < manifest.count; i++)
+	{
+		ShardResult *result = &job.results[i];
+		if (result->opened)
+		{
+			printf("%s; %zu; %zu\n", manifest.files[i], result->scanned,
+			       result->matched);
+		}
+		else
+		{
+			printf("%s; не удалось открыть или обработать\n",
+			       manifest.files[i]);
+		}
+		scanned += result->scanned;
+		free(result->students.data);
+		free(result->gpa);
+		if (result->part != NULL)
+		{
+			fclose(result->part);
 		}
-		puts("Сортировка выполнена.\n");
-		return;
 	}
-	puts("Выход из режима сортировки...\n");
+	printf("Всего просмотрено записей: %zu за %.3lf с\n\n", scanned, seconds);
+	
+	free(job.results);
+	deleteShardManifest(&manifest);
 }
 
 int main()
 {
 	setlocale(LC_ALL, "rus");
 	
+#ifdef REGISTRY_PROFILE
+	atexit(printProfileReport);
+#endif
+	
 	int option = 1;
-	while (1 <= option && option <= 8)
+	while (1 <= option && option <= 24)
 	{
 		puts("Выберите операцию, которую хотите произвести:\n"
 			 "1. Создание (создать файл записей).\n"
@@ -418,6 +6140,28 @@ int main()
 			 "6. Редактировать (редактирование записи в файле).\n"
 			 "7. Удаление (удалить запись из файла).\n"
 			 "8. Сортировка (отсортировать записи в файле по критерию).\n"
+			 "9. Архивирование (сжать файл записей в архив).\n"
+			 "10. Распаковка (восстановить файл записей из архива).\n"
+			 "11. Просмотр записи архива по ее номеру.\n"
+			 "12. Генерация (создать файл записей со случайными "
+			 "студентами).\n"
+			 "13. Замер производительности операций с записями.\n"
+			 "14. Сравнение и слияние (сверить файл записей с "
+			 "обновленным).\n"
+			 "15. Постраничный просмотр (просмотреть большой файл "
+			 "записей по страницам).\n"
+			 "16. Удаление дубликатов (оставить одну запись на каждую "
+			 "пару фамилия-группа).\n"
+			 "17. Включить историю версий файла записей.\n"
+			 "18. Просмотр сохраненных версий файла записей.\n"
+			 "19. Откат файла записей к сохраненной версии.\n"
+			 "20. Статистика (распределения оценок, квантили среднего "
+			 "балла, корреляции).\n"
+			 "21. Экспорт (выгрузить файл записей в JSON или CSV).\n"
+			 "22. Создание реестра из нескольких файлов записей.\n"
+			 "23. Добавление записи в реестр из нескольких файлов.\n"
+			 "24. Запрос к реестру из нескольких файлов (поиск, отбор, "
+			 "лучшие записи, статистика).\n"
 			 "Любое другое число - выход из программы.");
 		scanf("%d", &option);
 		
@@ -427,17 +6171,24 @@ int main()
 		
 		char fileName[STRING_BUFFER_MAX_SIZE];
 		FILE *notes;
+		StudentArray previous;
+		int sortCriterion;
 		
 		char outputFileName[STRING_BUFFER_MAX_SIZE];
 		FILE *output;
 		
+		FILE *archive;
+		
+		char reportFileName[STRING_BUFFER_MAX_SIZE];
+		int policy;
+		
 		switch (option)
 		{
 			case 1:
 				puts("Введите название нового файла записей (если файл "
 					 "записей существовал до этого, то все данные из него "
 					 "будут удалены):");
-				scanf("%s", fileName);
+				scanString(fileName);
 				
 				createFile(fileName);
 				
@@ -445,11 +6196,9 @@ int main()
 			case 2:
 				puts("Введите название файла, содержимое которого вы хотите "
 					 "просмотреть:");
-				scanf("%s", fileName);
+				scanString(fileName);
 				
-				notes = fopen(fileName, "r");
-				students = getStudents(notes);
-				fclose(notes);
+				students = loadNotes(fileName);
 				
 				viewFile(students);
 				
@@ -457,7 +6206,7 @@ int main()
 			case 3:
 				puts("Введите название файла, содержимое которого вы хотите "
 				     "просмотреть:");
-				scanf("%s", fileName);
+				scanString(fileName);
 				
 				FILE *file = fopen(fileName, "r");
 				readFile(file);
@@ -466,27 +6215,28 @@ int main()
 				break;
 			case 4:
 				puts("Введите название файла, куда вы хотите добавить запись:");
-				scanf("%s", fileName);
+				scanString(fileName);
 				
+				previous = getNotesSnapshot(fileName);
 				notes = fopen(fileName, "a");
 				addNote(notes);
 				fclose(notes);
+				recordNotesVersion(fileName, previous, "Добавление записи");
+				free(previous.data);
 				
 				break;
 			case 5:
 				puts("Введите название файла, информацию из которого вы "
 					 "хотите получить:");
-				scanf("%s", fileName);
+				scanString(fileName);
 				
 				puts("Введите название файла, в который вы хотите записать "
 				     "полученную информацию (если файла не существует, он "
 					 "будет создан, а если существует, то вся находящаяся "
 					 "в нем информация будет уничтожена):");
-				scanf("%s", outputFileName);
+				scanString(outputFileName);
 				
-				notes = fopen(fileName, "r");
-				students = getStudents(notes);
-				fclose(notes);
+				students = loadNotes(fileName);
 				
 				output = fopen(outputFileName, "w");
 				solveIndividualTask(output, students);
@@ -496,49 +6246,426 @@ int main()
 			case 6:
 				puts("Введите название файла, информацию в котором вы "
 				     "хотите изменить:");
-				scanf("%s", fileName);
+				scanString(fileName);
 				
 				notes = fopen(fileName, "r");
-				students = getStudents(notes);
+				students = getStudentsWithOrder(notes, &sortCriterion);
 				fclose(notes);
 				
+				previous = getNotesSnapshot(fileName);
 				editNote(&students);
+				if (sortCriterion != 0 &&
+				    !isSortedRange(students.data, students.size, sortCriterion))
+				{
+					sortCriterion = 0;
+				}
 				
 				notes = fopen(fileName, "w");
-				writeStudentsToFile(notes, students);
+				writeSortedStudentsToFile(notes, students, sortCriterion);
 				fclose(notes);
+				recordNotesVersion(fileName, previous, "Редактирование записи");
+				free(previous.data);
 				
 				break;
 			case 7:
 				puts("Введите название файла, информацию из которого вы "
 				     "хотите удалить:");
-				scanf("%s", fileName);
+				scanString(fileName);
 				
 				notes = fopen(fileName, "r");
-				students = getStudents(notes);
+				students = getStudentsWithOrder(notes, &sortCriterion);
 				fclose(notes);
 				
+				previous = getNotesSnapshot(fileName);
 				removeNote(&students);
+				if (sortCriterion != 0 &&
+				    !isSortedRange(students.data, students.size, sortCriterion))
+				{
+					sortCriterion = 0;
+				}
 				
 				notes = fopen(fileName, "w");
-				writeStudentsToFile(notes, students);
+				writeSortedStudentsToFile(notes, students, sortCriterion);
 				fclose(notes);
+				recordNotesVersion(fileName, previous, "Удаление записи");
+				free(previous.data);
 				
 				break;
 			case 8:
 				puts("Введите название файла, записи в котором вы "
 				     "хотите отсортировать:");
-				scanf("%s", fileName);
+				scanString(fileName);
 				
 				notes = fopen(fileName, "r");
-				students = getStudents(notes);
+				students = getStudentsWithOrder(notes, &sortCriterion);
+				fclose(notes);
+				
+				previous = getNotesSnapshot(fileName);
+				sortCriterion = sortNotes(&students, sortCriterion);
+				
+				notes = fopen(fileName, "w");
+				writeSortedStudentsToFile(notes, students, sortCriterion);
 				fclose(notes);
+				recordNotesVersion(fileName, previous, "Сортировка записей");
+				free(previous.data);
+				
+				break;
+			case 9:
+				puts("Введите название файла записей, который вы хотите "
+				     "сжать:");
+				scanString(fileName);
+				
+				puts("Введите название файла архива (если файл существует, "
+				     "то вся находящаяся в нем информация будет "
+				     "уничтожена):");
+				scanString(outputFileName);
+				
+				compressNotes(fileName, outputFileName);
+				
+				break;
+			case 10:
+				puts("Введите название файла архива:");
+				scanString(outputFileName);
+				
+				puts("Введите название файла записей, в который будет "
+				     "распакован архив (если файл существует, то вся "
+				     "находящаяся в нем информация будет уничтожена):");
+				scanString(fileName);
+				
+				archive = fopen(outputFileName, "rb");
+				if (archive == NULL ||
+				    !getStudentsFromArchive(archive, &students))
+				{
+					puts("Не удалось прочитать архив!\n");
+				}
+				else
+				{
+					notes = fopen(fileName, "w");
+					writeStudentsToFile(notes, students);
+					fclose(notes);
+					puts("Архив распакован.\n");
+				}
+				if (archive != NULL)
+				{
+					fclose(archive);
+				}
+				
+				break;
+			case 11:
+				puts("Введите название файла архива:");
+				scanString(outputFileName);
+				
+				puts("Введите номер записи:");
+				size_t studentNumber = 0;
+				scanf("%zu", &studentNumber);
+				
+				Student student;
+				archive = fopen(outputFileName, "rb");
+				if (archive != NULL && studentNumber != 0 &&
+				    getStudentFromArchive(archive, studentNumber - 1,
+				                          &student))
+				{
+					students.data = &student;
+					students.size = 1;
+					viewFile(students);
+					students.data = NULL;
+					students.size = 0;
+				}
+				else
+				{
+					puts("Нет такой записи!\n");
+				}
+				if (archive != NULL)
+				{
+					fclose(archive);
+				}
+				
+				break;
+			case 12:
+				puts("Введите название нового файла записей (если файл "
+					 "записей существовал до этого, то все данные из него "
+					 "будут удалены):");
+				scanString(fileName);
+				
+				puts("Введите количество студентов:");
+				size_t studentCount = 0;
+				scanf("%zu", &studentCount);
 				
-				sortNotes(&students);
+				puts("Введите начальное значение генератора случайных "
+				     "чисел:");
+				uint64_t seed = 0;
+				scanf("%" SCNu64, &seed);
 				
 				notes = fopen(fileName, "w");
-				writeStudentsToFile(notes, students);
+				generateNotes(notes, studentCount, seed);
 				fclose(notes);
+				puts("Файл записей создан.\n");
+				
+				break;
+			case 13:
+				puts("Введите название файла, в который будут записаны "
+				     "результаты замеров (по одному JSON-объекту в "
+				     "строке):");
+				scanString(outputFileName);
+				
+				puts("Введите максимальное количество записей (замеры "
+				     "проводятся для 1000, 100000, 1000000 и 10000000 "
+				     "записей):");
+				size_t maxRecords = 0;
+				scanf("%zu", &maxRecords);
+				
+				benchmarkNotes(outputFileName, maxRecords);
+				
+				break;
+			case 14:
+				printf("Основной файл загружается в память целиком (около "
+				       "%zu байт на запись), обновленный файл читается "
+				       "потоково.\n", sizeof(Student));
+				puts("Введите название основного файла записей:");
+				scanString(fileName);
+				
+				puts("Введите название обновленного файла записей:");
+				char updateFileName[STRING_BUFFER_MAX_SIZE];
+				scanString(updateFileName);
+				
+				puts("Введите название файла для отчета о различиях:");
+				scanString(reportFileName);
+				
+				puts("Введите название файла для объединенных записей (если "
+				     "файл существует, то вся находящаяся в нем информация "
+				     "будет уничтожена):");
+				scanString(outputFileName);
+				
+				puts("Выберите, какая запись попадет в результат при "
+				     "расхождении:\n"
+				     "1. Запись из основного файла.\n"
+				     "2. Запись из обновленного файла.\n"
+				     "3. Наибольшие значения оценок и среднего балла из "
+				     "обеих записей.");
+				policy = MERGE_KEEP_MASTER;
+				scanf("%d", &policy);
+				if (policy < MERGE_KEEP_MASTER || policy > MERGE_TAKE_MAXIMUM)
+				{
+					policy = MERGE_KEEP_MASTER;
+				}
+				
+				puts("Удалить записи, которых нет в обновленном файле? "
+				     "(1 - да, любое другое число - нет)");
+				int dropRemoved = 0;
+				scanf("%d", &dropRemoved);
+				
+				mergeNotes(fileName, updateFileName, reportFileName,
+				           outputFileName, (MergePolicy)policy,
+				           dropRemoved == 1);
+				
+				break;
+			case 15:
+				puts("Введите название файла, содержимое которого вы хотите "
+				     "просмотреть:");
+				scanString(fileName);
+				
+				viewNotesPaged(fileName);
+				
+				break;
+			case 16:
+				puts("Введите название файла записей, из которого нужно "
+				     "удалить дубликаты:");
+				scanString(fileName);
+				
+				puts("Введите название файла для записей без дубликатов "
+				     "(если файл существует, то вся находящаяся в нем "
+				     "информация будет уничтожена):");
+				scanString(outputFileName);
+				
+				puts("Введите название файла для отчета о дубликатах:");
+				scanString(reportFileName);
+				
+				puts("Выберите, какая запись останется вместо дубликатов:\n"
+				     "1. Последняя по порядку в файле.\n"
+				     "2. С наибольшим средним баллом.\n"
+				     "3. Наибольшие значения оценок и среднего балла из "
+				     "всех дубликатов.");
+				policy = DEDUPLICATE_LATEST;
+				scanf("%d", &policy);
+				if (policy < DEDUPLICATE_LATEST || policy > DEDUPLICATE_MAXIMUM)
+				{
+					policy = DEDUPLICATE_LATEST;
+				}
+				
+				deduplicateNotes(fileName, outputFileName, reportFileName,
+				                 (DeduplicationPolicy)policy);
+				
+				break;
+			case 17:
+				puts("Введите название файла записей, для которого нужно "
+				     "вести историю версий:");
+				scanString(fileName);
+				
+				enableNotesHistory(fileName);
+				
+				break;
+			case 18:
+				puts("Введите название файла записей:");
+				scanString(fileName);
+				
+				listNotesVersions(fileName);
+				
+				break;
+			case 19:
+				puts("Введите название файла записей:");
+				scanString(fileName);
+				
+				listNotesVersions(fileName);
+				puts("Введите номер версии, к которой нужно вернуться:");
+				uint64_t version = 0;
+				scanf("%" SCNu64, &version);
+				
+				restoreNotesVersion(fileName, version);
+				
+				break;
+			case 20:
+				puts("Введите название файла записей:");
+				scanString(fileName);
+				
+				showStatistics(fileName);
+				
+				break;
+			case 21:
+				puts("Введите название файла записей:");
+				scanString(fileName);
+				
+				puts("Введите название файла для экспорта (если файл "
+				     "существует, то вся находящаяся в нем информация будет "
+				     "уничтожена):");
+				scanString(outputFileName);
+				
+				puts("Выберите формат:\n"
+				     "1. JSON (массив объектов).\n"
+				     "2. CSV (первая строка - названия полей).");
+				int format = EXPORT_JSON;
+				scanf("%d", &format);
+				if (format != EXPORT_CSV)
+				{
+					format = EXPORT_JSON;
+				}
+				
+				exportNotes(fileName, outputFileName, (ExportFormat)format);
+				
+				break;
+			case 22:
+				puts("Введите название файла манифеста реестра (файлы "
+				     "частей получат имена <манифест>.0, <манифест>.1 и так "
+				     "далее; если файлы существуют, то вся находящаяся в них "
+				     "информация будет уничтожена):");
+				scanString(fileName);
+				
+				puts("Введите количество файлов в реестре:");
+				size_t shardCount = 0;
+				scanf("%zu", &shardCount);
+				if (shardCount == 0)
+				{
+					puts("В реестре должен быть хотя бы один файл!\n");
+					break;
+				}
+				
+				createShardedRegistry(fileName, shardCount);
+				
+				break;
+			case 23:
+				puts("Введите название файла манифеста реестра:");
+				scanString(fileName);
+				
+				addShardedNote(fileName);
+				
+				break;
+			case 24:
+				puts("Введите название файла манифеста реестра:");
+				scanString(fileName);
+				
+				puts("Выберите запрос:\n"
+				     "1. Поиск записей по фамилии.\n"
+				     "2. Отбор записей по диапазону значений поля.\n"
+				     "3. Лучшие записи по критерию сортировки.\n"
+				     "4. Статистика по всем записям реестра.");
+				ShardQuery query;
+				query.kind = SHARD_QUERY_STATISTICS;
+				int kind = 0;
+				scanf("%d", &kind);
+				if (kind < SHARD_QUERY_SEARCH || kind > SHARD_QUERY_STATISTICS)
+				{
+					puts("Нет такого запроса!\n");
+					break;
+				}
+				query.kind = (ShardQueryKind)kind;
+				
+				if (query.kind == SHARD_QUERY_SEARCH)
+				{
+					puts("Введите фамилию студента:");
+					scanString(query.surname);
+				}
+				else if (query.kind == SHARD_QUERY_FILTER)
+				{
+					puts("Выберите поле:");
+					for (int field = 0; field < STUDENT_FIELD_COUNT; field++)
+					{
+						if (STUDENT_FIELD_DESCRIPTORS[field].type !=
+						    FIELD_TYPE_STRING)
+						{
+							printf("%d. %s.\n", field + 1,
+							       STUDENT_FIELD_TITLES[field]);
+						}
+					}
+					query.field = 0;
+					scanf("%d", &query.field);
+					query.field--;
+					if (query.field < 0 || query.field >= STUDENT_FIELD_COUNT ||
+					    STUDENT_FIELD_DESCRIPTORS[query.field].type ==
+					    FIELD_TYPE_STRING)
+					{
+						puts("Нет такого поля!\n");
+						break;
+					}
+					puts("Введите наименьшее и наибольшее значение поля:");
+					if (scanf("%lf %lf", &query.minimum, &query.maximum) != 2)
+					{
+						puts("Неверный диапазон!\n");
+						break;
+					}
+					
+					puts("Введите название файла для отобранных записей (если "
+					     "файл существует, то вся находящаяся в нем "
+					     "информация будет уничтожена):");
+					scanString(outputFileName);
+				}
+				else if (query.kind == SHARD_QUERY_TOP)
+				{
+					puts("Выберите критерий:");
+					for (int criterion = 1;
+					     criterion <= STUDENT_SORT_CRITERION_COUNT; criterion++)
+					{
+						printf("%d. %s.\n", criterion,
+						       STUDENT_SORT_CRITERION_TITLES[criterion - 1]);
+					}
+					query.criterion = 0;
+					scanf("%d", &query.criterion);
+					if (query.criterion < 1 ||
+					    query.criterion > STUDENT_SORT_CRITERION_COUNT)
+					{
+						puts("Нет такого критерия!\n");
+						break;
+					}
+					printf("Введите количество записей (не больше %d):\n",
+					       SHARD_TOP_MAX_SIZE);
+					query.limit = 0;
+					scanf("%zu", &query.limit);
+					if (query.limit == 0 || query.limit > SHARD_TOP_MAX_SIZE)
+					{
+						puts("Неверное количество записей!\n");
+						break;
+					}
+				}
+				
+				queryShardedRegistry(fileName, &query, outputFileName);
 				
 				break;
 			default: